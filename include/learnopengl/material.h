@@ -0,0 +1,125 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+#include <rg/GLState.h>
+
+#include <string>
+#include <vector>
+
+// Every sampler a model shader can declare gets a fixed texture unit:
+// texture_diffuseN, texture_specularN, texture_normalN and texture_heightN use unit
+// (N - 1) * MATERIAL_TEXTURE_TYPES + type. The units never change, so sampler uniforms are set
+// once per program and drawing a material only binds textures.
+enum MaterialTextureType {
+    MATERIAL_DIFFUSE = 0,
+    MATERIAL_SPECULAR,
+    MATERIAL_NORMAL,
+    MATERIAL_HEIGHT,
+    MATERIAL_TEXTURE_TYPES
+};
+
+const unsigned int MAX_TEXTURES_PER_TYPE = 4;
+const unsigned int MAX_MATERIAL_TEXTURES = MATERIAL_TEXTURE_TYPES * MAX_TEXTURES_PER_TYPE;
+
+inline const char *materialTextureTypeName(unsigned int type)
+{
+    static const char *names[MATERIAL_TEXTURE_TYPES] = {
+            "texture_diffuse", "texture_specular", "texture_normal", "texture_height"
+    };
+    return names[type];
+}
+
+// returns MATERIAL_TEXTURE_TYPES for unknown type names
+inline unsigned int materialTextureTypeFromName(const std::string &name)
+{
+    for (unsigned int type = 0; type < MATERIAL_TEXTURE_TYPES; type++)
+        if (name == materialTextureTypeName(type))
+            return type;
+    return MATERIAL_TEXTURE_TYPES;
+}
+
+// textures of a mesh resolved at load time to the units they are sampled from
+struct Material {
+    unsigned int textureIds[MAX_MATERIAL_TEXTURES];
+    unsigned char units[MAX_MATERIAL_TEXTURES];
+    unsigned int textureCount = 0;
+
+    // texture types are Texture::type names ("texture_diffuse", ...), in mesh order
+    template <typename TextureList>
+    static Material fromTextures(const TextureList &textures)
+    {
+        Material material;
+        unsigned int perType[MATERIAL_TEXTURE_TYPES] = {0};
+        for (const auto &texture : textures)
+        {
+            unsigned int type = materialTextureTypeFromName(texture.type);
+            if (type == MATERIAL_TEXTURE_TYPES || perType[type] == MAX_TEXTURES_PER_TYPE)
+                continue;
+            material.textureIds[material.textureCount] = texture.id;
+            material.units[material.textureCount] = perType[type]++ * MATERIAL_TEXTURE_TYPES + type;
+            material.textureCount++;
+        }
+        // samplers without a texture used to default to unit 0, i.e. the first texture of the mesh
+        if (material.textureCount > 0)
+        {
+            unsigned int first = material.textureIds[0];
+            for (unsigned int type = 0; type < MATERIAL_TEXTURE_TYPES; type++)
+            {
+                if (perType[type] > 0)
+                    continue;
+                material.textureIds[material.textureCount] = first;
+                material.units[material.textureCount] = type;
+                material.textureCount++;
+            }
+        }
+        return material;
+    }
+
+    void bind() const
+    {
+        for (unsigned int i = 0; i < textureCount; i++)
+        {
+            rg::glState().bindTexture(units[i], GL_TEXTURE_2D, textureIds[i]);
+        }
+    }
+};
+
+// Remembers which programs already have their material samplers pointed at the fixed units.
+// Sampler uniforms are program state, so each program is configured only on its first draw.
+class MaterialSamplers {
+public:
+    // the program has to be in use
+    void prepare(const Shader &shader)
+    {
+        for (unsigned int program : configuredPrograms)
+            if (program == shader.ID)
+                return;
+
+        for (unsigned int type = 0; type < MATERIAL_TEXTURE_TYPES; type++)
+        {
+            for (unsigned int n = 0; n < MAX_TEXTURES_PER_TYPE; n++)
+            {
+                std::string name = prefix + materialTextureTypeName(type) + std::to_string(n + 1);
+                int location = glGetUniformLocation(shader.ID, name.c_str());
+                if (location != -1)
+                    glUniform1i(location, n * MATERIAL_TEXTURE_TYPES + type);
+            }
+        }
+        configuredPrograms.push_back(shader.ID);
+    }
+
+    void setPrefix(const std::string &glslIdentifierPrefix)
+    {
+        prefix = glslIdentifierPrefix;
+        configuredPrograms.clear();
+    }
+
+private:
+    std::string prefix;
+    std::vector<unsigned int> configuredPrograms;
+};
+
+#endif
@@ -12,7 +12,10 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <rg/FrameStats.h>
+#include <rg/GLExtensions.h>
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -33,6 +36,9 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // object space bounds of all meshes
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
 
     // constructor, expects a filepath to a 3D model.
     Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
@@ -40,19 +46,67 @@ public:
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
+    // draws the model, and thus all its meshes.
+    // All meshes live in one vertex/index buffer, so there is a single VAO bind and one
+    // multi-draw per material instead of one bind and draw call per mesh.
     void Draw(Shader &shader)
     {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        samplers.prepare(shader);
+
+        rg::glState().bindVertexArray(VAO);
+        if (indirectBuffer)
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+        for (const DrawBatch &batch : batches)
+        {
+            meshes[batch.meshIndex].material.bind();
+            rg::frameStats().countDraw(GL_TRIANGLES, batch.indexCount);
+            if (indirectBuffer)
+                rg::glExtensions().MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                        (const void *) (batch.firstDraw * sizeof(rg::DrawElementsIndirectCommand)),
+                        batch.drawCount, 0);
+            else
+                glMultiDrawElementsBaseVertex(GL_TRIANGLES, &drawCounts[batch.firstDraw], GL_UNSIGNED_INT,
+                        &drawOffsets[batch.firstDraw], batch.drawCount, &drawBaseVertices[batch.firstDraw]);
+        }
+
+        if (indirectBuffer)
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // drops the CPU side vertices and indices of every mesh, keeping only counts and bounds
+    void ReleaseGeometry()
+    {
+        for (Mesh& mesh: meshes)
+            mesh.releaseGeometry();
     }
 
     void SetShaderTextureNamePrefix(std::string prefix) {
+        samplers.setPrefix(prefix);
         for (Mesh& mesh: meshes) {
-            mesh.glslIdentifierPrefix = prefix;
+            mesh.setShaderTextureNamePrefix(prefix);
         }
     }
 private:
+    // consecutive meshes (in draw order) that share a material, submitted with one multi-draw call
+    struct DrawBatch {
+        unsigned int meshIndex;   // any mesh of the batch, used for its textures
+        unsigned int firstDraw;   // first entry in the draw arrays / indirect buffer
+        GLsizei drawCount;
+        GLsizei indexCount;       // of all its meshes, for the frame statistics
+    };
+
+    // shared geometry of all meshes
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    unsigned int indirectBuffer = 0;
+
+    vector<DrawBatch> batches;
+    MaterialSamplers samplers;
+    // per-mesh arguments for glMultiDrawElementsBaseVertex, sorted by material
+    vector<GLsizei> drawCounts;
+    vector<const void *> drawOffsets;
+    vector<GLint> drawBaseVertices;
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
@@ -68,8 +122,85 @@ private:
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
 
+        meshes.reserve(scene->mNumMeshes);
+
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+
+        setupSharedBuffers();
+    }
+
+    // packs every mesh into one VBO/EBO, ordered by material, and records the per-mesh offsets
+    void setupSharedBuffers()
+    {
+        vector<unsigned int> order(meshes.size());
+        for (unsigned int i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+            return meshes[a].materialIndex < meshes[b].materialIndex;
+        });
+
+        size_t totalVertices = 0;
+        size_t totalIndices = 0;
+        for (const Mesh &mesh : meshes)
+        {
+            if (mesh.vertexCount == 0)
+                continue;
+            boundsMin = totalVertices == 0 ? mesh.boundsMin : glm::min(boundsMin, mesh.boundsMin);
+            boundsMax = totalVertices == 0 ? mesh.boundsMax : glm::max(boundsMax, mesh.boundsMax);
+            totalVertices += mesh.vertexCount;
+            totalIndices += mesh.indexCount;
+        }
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, totalVertices * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, totalIndices * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+        vector<rg::DrawElementsIndirectCommand> commands;
+        commands.reserve(meshes.size());
+        drawCounts.reserve(meshes.size());
+        drawOffsets.reserve(meshes.size());
+        drawBaseVertices.reserve(meshes.size());
+
+        GLuint baseVertex = 0;
+        GLuint firstIndex = 0;
+        for (unsigned int meshIndex : order)
+        {
+            const Mesh &mesh = meshes[meshIndex];
+            glBufferSubData(GL_ARRAY_BUFFER, baseVertex * sizeof(Vertex), mesh.vertexCount * sizeof(Vertex), mesh.vertices.data());
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(unsigned int), mesh.indexCount * sizeof(unsigned int), mesh.indices.data());
+
+            if (batches.empty() || meshes[batches.back().meshIndex].materialIndex != mesh.materialIndex)
+                batches.push_back(DrawBatch{meshIndex, (unsigned int) drawCounts.size(), 0, 0});
+            batches.back().drawCount++;
+            batches.back().indexCount += mesh.indexCount;
+
+            drawCounts.push_back(mesh.indexCount);
+            drawOffsets.push_back((const void *) (firstIndex * sizeof(unsigned int)));
+            drawBaseVertices.push_back(baseVertex);
+            commands.push_back(rg::DrawElementsIndirectCommand{mesh.indexCount, 1, firstIndex, (GLint) baseVertex, 0});
+
+            baseVertex += mesh.vertexCount;
+            firstIndex += mesh.indexCount;
+        }
+
+        Mesh::setupVertexAttributes();
+        glBindVertexArray(0);
+
+        // with GL 4.3 the draw arguments live on the GPU and each batch is a single indirect call
+        if (rg::glExtensions().multiDrawIndirect)
+        {
+            glGenBuffers(1, &indirectBuffer);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(rg::DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -97,6 +228,8 @@ private:
         vector<Vertex> vertices;
         vector<unsigned int> indices;
         vector<Texture> textures;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -146,7 +279,7 @@ private:
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
@@ -179,7 +312,10 @@ private:
 
 
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // the mesh is uploaded later together with the rest of the model, see setupSharedBuffers()
+        Mesh result(std::move(vertices), std::move(indices), std::move(textures), false);
+        result.materialIndex = mesh->mMaterialIndex;
+        return result;
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
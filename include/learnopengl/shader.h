@@ -9,6 +9,25 @@
 #include <sstream>
 #include <iostream>
 #include <common.h>
+#include <rg/FrameStats.h>
+#include <rg/GLExtensions.h>
+#include <rg/GLState.h>
+
+// name argument of the uniform setters: a string literal or a std::string, neither is copied.
+// Literals used to become a std::string temporary per call, a heap allocation for every name
+// longer than the small string buffer, several hundred times a frame.
+class UniformName
+{
+public:
+    UniformName(const char *name) : name(name) {}
+    UniformName(const std::string &name) : name(name.c_str()) {}
+
+    const char *c_str() const { return name; }
+
+private:
+    const char *name;
+};
+
 class Shader
 {
 public:
@@ -64,111 +83,171 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
+        compile(vertexCode.c_str(), fragmentCode.c_str(), geometryPath != nullptr ? geometryCode.c_str() : nullptr);
+    }
+    // program that is built later from sources, see compile()
+    // ------------------------------------------------------------------------
+    Shader() : ID(0)
+    {
+    }
+    // compiles and links the program from already loaded sources
+    // ------------------------------------------------------------------------
+    void compile(const char* vShaderCode, const char* fShaderCode, const char* gShaderCode = nullptr)
+    {
+        beginCompile(vShaderCode, fShaderCode, gShaderCode);
+        finishCompile();
+    }
+    // submits compile and link to the driver without waiting for the result; with
+    // KHR_parallel_shader_compile the driver works on it in the background until finishCompile()
+    // ------------------------------------------------------------------------
+    void beginCompile(const char* vShaderCode, const char* fShaderCode, const char* gShaderCode = nullptr)
+    {
         // 2. compile shaders
-        unsigned int vertex, fragment;
         // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+        pendingShaders[0] = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(pendingShaders[0], 1, &vShaderCode, NULL);
+        glCompileShader(pendingShaders[0]);
         // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+        pendingShaders[1] = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(pendingShaders[1], 1, &fShaderCode, NULL);
+        glCompileShader(pendingShaders[1]);
         // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
+        pendingShaders[2] = 0;
+        if(gShaderCode != nullptr)
         {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            pendingShaders[2] = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(pendingShaders[2], 1, &gShaderCode, NULL);
+            glCompileShader(pendingShaders[2]);
         }
         // shader Program
         ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
+        // lets rg::ShaderLibrary store the linked program in its binary cache
+        if(rg::glExtensions().programBinary)
+            rg::glExtensions().ProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        for(unsigned int shader : pendingShaders)
+            if(shader != 0)
+                glAttachShader(ID, shader);
         glLinkProgram(ID);
+    }
+    // true when finishCompile() will not block; always true without KHR_parallel_shader_compile
+    // ------------------------------------------------------------------------
+    bool isCompileReady() const
+    {
+        if(!rg::glExtensions().parallelShaderCompile || pendingShaders[0] == 0)
+            return true;
+        GLint done = GL_TRUE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+    // collects the compile and link status of beginCompile()
+    // ------------------------------------------------------------------------
+    void finishCompile()
+    {
+        static const char* types[] = {"VERTEX", "FRAGMENT", "GEOMETRY"};
+        for(int i = 0; i < 3; i++)
+            if(pendingShaders[i] != 0)
+                checkCompileErrors(pendingShaders[i], types[i]);
         checkCompileErrors(ID, "PROGRAM");
         // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+        for(unsigned int &shader : pendingShaders)
+        {
+            if(shader != 0)
+                glDeleteShader(shader);
+            shader = 0;
+        }
     }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        rg::glState().useProgram(ID);
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(UniformName name, bool value) const
     {         
+        rg::frameStats().countUniform();
         glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(UniformName name, int value) const
     { 
+        rg::frameStats().countUniform();
         glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(UniformName name, float value) const
     { 
+        rg::frameStats().countUniform();
         glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(UniformName name, const glm::vec2 &value) const
     { 
+        rg::frameStats().countUniform();
         glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(UniformName name, float x, float y) const
     { 
+        rg::frameStats().countUniform();
         glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(UniformName name, const glm::vec3 &value) const
     { 
+        rg::frameStats().countUniform();
         glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(UniformName name, float x, float y, float z) const
     { 
+        rg::frameStats().countUniform();
         glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(UniformName name, const glm::vec4 &value) const
     { 
+        rg::frameStats().countUniform();
         glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(UniformName name, float x, float y, float z, float w) 
     { 
+        rg::frameStats().countUniform();
         glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(UniformName name, const glm::mat2 &mat) const
     {
+        rg::frameStats().countUniform();
         glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(UniformName name, const glm::mat3 &mat) const
     {
+        rg::frameStats().countUniform();
         glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(UniformName name, const glm::mat4 &mat) const
     {
+        rg::frameStats().countUniform();
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
     }
+    // ------------------------------------------------------------------------
+    // uniform arrays, count elements starting with the first one, in one call
+    void setFloatArray(UniformName name, const float *values, int count) const
+    {
+        rg::frameStats().countUniform();
+        glUniform1fv(glGetUniformLocation(ID, name.c_str()), count, values);
+    }
+    void setMat4Array(UniformName name, const glm::mat4 *mats, int count) const
+    {
+        rg::frameStats().countUniform();
+        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), count, GL_FALSE, &mats[0][0][0]);
+    }
 
 private:
+    // vertex, fragment and geometry shader between beginCompile() and finishCompile()
+    unsigned int pendingShaders[3] = {0, 0, 0};
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,100 @@
+//
+// Heap allocation tracking. Built with RG_ALLOCATION_TRACKING=1 the global operator new counts
+// every allocation of the calling thread; profiler zones take the count at their start and end,
+// so allocations show up under the zone that made them. Without it the counters stay zero and
+// nothing is replaced. C allocations, e.g. inside the driver or GLFW, are not seen.
+//
+// The replacement operators are defined in the one translation unit that defines
+// RG_ALLOCATION_HOOKS before including this header, like STB_IMAGE_IMPLEMENTATION.
+//
+
+#ifndef PROJECT_BASE_ALLOCATIONTRACKER_H
+#define PROJECT_BASE_ALLOCATIONTRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifndef RG_ALLOCATION_TRACKING
+#define RG_ALLOCATION_TRACKING 0
+#endif
+
+namespace rg {
+
+struct AllocationCounters {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+// counters of the calling thread; plain zero initialization, so the first use does not allocate
+inline AllocationCounters &threadAllocations() {
+    static thread_local AllocationCounters counters = {0, 0};
+    return counters;
+}
+
+inline void countAllocation(size_t bytes) {
+    AllocationCounters &counters = threadAllocations();
+    ++counters.allocations;
+    counters.bytes += bytes;
+}
+
+};
+
+#if defined(RG_ALLOCATION_HOOKS) && RG_ALLOCATION_TRACKING
+
+void *operator new(std::size_t size) {
+    rg::countAllocation(size);
+    for (;;) {
+        if (void *memory = std::malloc(size ? size : 1))
+            return memory;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) noexcept {
+    std::free(memory);
+}
+
+#endif
+
+#endif //PROJECT_BASE_ALLOCATIONTRACKER_H
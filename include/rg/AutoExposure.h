@@ -0,0 +1,169 @@
+//
+// Automatic exposure. A pass writes the log luminance of the scene into a small texture, its
+// mip chain averages it down to one texel, and that texel is copied into a pixel buffer. The
+// buffers form a ring guarded by fences and are only mapped once the GPU is done with them, so
+// the CPU never waits; the exposure follows the measured luminance a few frames late, which the
+// adaptation smooths over anyway.
+//
+
+#ifndef PROJECT_BASE_AUTOEXPOSURE_H
+#define PROJECT_BASE_AUTOEXPOSURE_H
+
+#include <glad/glad.h>
+
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rg {
+
+struct AutoExposureSettings {
+    bool enabled = true;
+    // exposure * average luminance the tonemapper should see
+    float key = 0.5f;
+    // in stops, on top of the measured exposure
+    float compensation = 0.0f;
+    float minExposure = 0.1f;
+    float maxExposure = 10.0f;
+    // how fast the exposure follows the scene, per second
+    float adaptationSpeed = 1.5f;
+};
+
+class AutoExposure {
+public:
+    // width and height of the luminance texture; a power of two, so every mip level halves exactly
+    static const int SIZE = 256;
+    static const int LEVELS = 9;
+    static const unsigned int READBACKS = 3;
+
+    AutoExposure() {
+        glGenTextures(1, &m_texture);
+        glState().bindTexture(0, GL_TEXTURE_2D, m_texture);
+        for (int level = 0, size = SIZE; level < LEVELS; ++level, size /= 2)
+            glTexImage2D(GL_TEXTURE_2D, level, GL_R16F, size, size, 0, GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, LEVELS - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // one framebuffer renders into the full-size level, the other reads the 1x1 level
+        glGenFramebuffers(2, m_framebuffers);
+        glState().bindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[0]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+        glState().bindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[1]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, LEVELS - 1);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        labelObject(GL_TEXTURE, m_texture, "log luminance");
+        labelObject(GL_FRAMEBUFFER, m_framebuffers[0], "log luminance");
+        labelObject(GL_FRAMEBUFFER, m_framebuffers[1], "log luminance readback");
+
+        glGenBuffers(READBACKS, m_buffers);
+        for (GLuint buffer : m_buffers) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(float), NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        for (GLsync &fence : m_fences)
+            fence = 0;
+    }
+
+    ~AutoExposure() {
+        for (GLsync fence : m_fences)
+            if (fence)
+                glDeleteSync(fence);
+        glDeleteBuffers(READBACKS, m_buffers);
+        glDeleteFramebuffers(2, m_framebuffers);
+        glDeleteTextures(1, &m_texture);
+    }
+
+    AutoExposure(const AutoExposure &) = delete;
+    AutoExposure &operator=(const AutoExposure &) = delete;
+
+    // target of the luminance pass, SIZE x SIZE
+    GLuint framebuffer() const {
+        return m_framebuffers[0];
+    }
+
+    GLuint texture() const {
+        return m_texture;
+    }
+
+    // after the luminance pass: averages it down and starts copying the result; skipped when
+    // every buffer of the ring is still in flight
+    void queueReadback() {
+        if (m_pending == READBACKS)
+            return;
+        glState().bindTexture(0, GL_TEXTURE_2D, m_texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glState().bindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffers[1]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[m_next]);
+        glReadPixels(0, 0, 1, 1, GL_RED, GL_FLOAT, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        m_fences[m_next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_next = (m_next + 1) % READBACKS;
+        ++m_pending;
+    }
+
+    // takes every finished readback without waiting and moves the exposure towards the newest one
+    void update(const AutoExposureSettings &settings, float deltaTime) {
+        while (m_pending > 0) {
+            unsigned int oldest = (m_next + READBACKS - m_pending) % READBACKS;
+            GLint status = GL_UNSIGNALED;
+            glGetSynciv(m_fences[oldest], GL_SYNC_STATUS, 1, NULL, &status);
+            if (status != GL_SIGNALED)
+                break;
+            glDeleteSync(m_fences[oldest]);
+            m_fences[oldest] = 0;
+            --m_pending;
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[oldest]);
+            const float *logLuminance = (const float *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(float),
+                                                                         GL_MAP_READ_BIT);
+            if (logLuminance) {
+                if (std::isfinite(*logLuminance))
+                    m_averageLuminance = std::exp(*logLuminance);
+                m_measured = true;
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        if (!m_measured)
+            return;
+
+        float target = settings.key / std::max(m_averageLuminance, 1e-4f) * std::exp2(settings.compensation);
+        target = std::min(std::max(target, settings.minExposure), settings.maxExposure);
+        // adapt in log space, so brightening and darkening by the same factor take equally long
+        float blend = 1.0f - std::exp(-deltaTime * settings.adaptationSpeed);
+        m_exposure = std::exp(std::log(m_exposure) + (std::log(target) - std::log(m_exposure)) * blend);
+    }
+
+    float exposure() const {
+        return m_exposure;
+    }
+
+    // geometric mean of the scene luminance from the newest finished readback
+    float averageLuminance() const {
+        return m_averageLuminance;
+    }
+
+    unsigned int pendingReadbacks() const {
+        return m_pending;
+    }
+
+private:
+    GLuint m_texture = 0;
+    GLuint m_framebuffers[2];
+    GLuint m_buffers[READBACKS];
+    GLsync m_fences[READBACKS];
+    unsigned int m_next = 0;
+    unsigned int m_pending = 0;
+    bool m_measured = false;
+    float m_averageLuminance = 1.0f;
+    float m_exposure = 1.0f;
+};
+
+};
+
+#endif //PROJECT_BASE_AUTOEXPOSURE_H
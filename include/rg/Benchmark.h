@@ -0,0 +1,408 @@
+//
+// Benchmark harness: runs the game for a fixed number of frames and switches between renderer
+// modes in short interleaved blocks, so every mode sees the same mix of scene content.
+// Reports CPU frame time, GPU scene time and the frame counters per mode.
+//
+// The allocation check runs the game loop after a warm-up and counts the frames that allocate.
+//
+// The startup benchmark launches the game repeatedly, each run presents one frame and exits,
+// and compares cold starts, with the game's files evicted from the page cache, to warm ones.
+//
+
+#ifndef PROJECT_BASE_BENCHMARK_H
+#define PROJECT_BASE_BENCHMARK_H
+
+#include <rg/AllocationTracker.h>
+#include <rg/FrameStats.h>
+#include <rg/Profiler.h>
+#include <rg/StartupTimeline.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rg {
+
+class Benchmark {
+public:
+    Benchmark() = default;
+
+    // framesPerMode measured frames of every mode, in blocks of blockFrames, after warmupFrames
+    void start(const std::vector<std::string> &modes, unsigned int framesPerMode, unsigned int blockFrames = 30,
+               unsigned int warmupFrames = 60) {
+        m_modes = modes;
+        m_blockFrames = std::max(blockFrames, 2u);
+        m_warmupFrames = warmupFrames;
+        m_totalFrames = warmupFrames + framesPerMode * (unsigned int) modes.size();
+        m_frame = 0;
+        m_cpu.assign(modes.size(), std::vector<double>());
+        m_gpu.assign(modes.size(), std::vector<double>());
+        m_counters.assign(modes.size(), FrameStatsTotals());
+        m_running = !modes.empty() && framesPerMode > 0;
+    }
+
+    bool running() const {
+        return m_running && m_frame < m_totalFrames;
+    }
+
+    bool finished() const {
+        return m_running && m_frame >= m_totalFrames;
+    }
+
+    // the mode the current frame has to render with
+    unsigned int mode() const {
+        return modeOf(m_frame);
+    }
+
+    // tag for GPU measurements of the current frame
+    uint32_t frame() const {
+        return m_frame;
+    }
+
+    // closes the current frame; counters are what the frame submitted, FrameStatsRecorder::snapshot()
+    void endFrame(double cpuMilliseconds, const FrameStats &counters) {
+        if (measured(m_frame)) {
+            m_cpu[modeOf(m_frame)].push_back(cpuMilliseconds);
+            m_counters[modeOf(m_frame)].add(counters);
+        }
+        ++m_frame;
+    }
+
+    // GPU results arrive a few frames late, the tag says which frame they belong to
+    void addGpuSample(uint32_t frame, double milliseconds) {
+        if (m_running && frame < m_totalFrames && measured(frame))
+            m_gpu[modeOf(frame)].push_back(milliseconds);
+    }
+
+    void report(std::ostream &out) const {
+        out << "Benchmark: " << m_totalFrames << " frames, blocks of " << m_blockFrames << '\n';
+        out << "mode          cpu mean   cpu p50   cpu p95   gpu mean   gpu p50   gpu p95  (ms)\n";
+        for (size_t mode = 0; mode < m_modes.size(); ++mode) {
+            char line[160];
+            Stats cpu = stats(m_cpu[mode]);
+            Stats gpu = stats(m_gpu[mode]);
+            std::snprintf(line, sizeof(line), "%-12s %9.3f %9.3f %9.3f  %9.3f %9.3f %9.3f\n",
+                          m_modes[mode].c_str(), cpu.mean, cpu.median, cpu.p95, gpu.mean, gpu.median, gpu.p95);
+            out << line;
+        }
+        for (size_t mode = 0; mode < m_modes.size(); ++mode)
+            m_counters[mode].report(out, m_modes[mode].c_str());
+    }
+
+private:
+    struct Stats {
+        double mean = 0.0;
+        double median = 0.0;
+        double p95 = 0.0;
+    };
+
+    static Stats stats(std::vector<double> samples) {
+        Stats result;
+        if (samples.empty())
+            return result;
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double sample : samples)
+            sum += sample;
+        result.mean = sum / samples.size();
+        result.median = samples[samples.size() / 2];
+        result.p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+        return result;
+    }
+
+    unsigned int modeOf(uint32_t frame) const {
+        if (m_modes.empty())
+            return 0;
+        uint32_t index = frame < m_warmupFrames ? frame : frame - m_warmupFrames;
+        return (index / m_blockFrames) % m_modes.size();
+    }
+
+    // the first frame of every block pays for the switch and is not counted
+    bool measured(uint32_t frame) const {
+        return frame >= m_warmupFrames && (frame - m_warmupFrames) % m_blockFrames != 0;
+    }
+
+    std::vector<std::string> m_modes;
+    unsigned int m_blockFrames = 30;
+    unsigned int m_warmupFrames = 0;
+    unsigned int m_totalFrames = 0;
+    uint32_t m_frame = 0;
+    bool m_running = false;
+    std::vector<std::vector<double>> m_cpu;
+    std::vector<FrameStatsTotals> m_counters;
+    std::vector<std::vector<double>> m_gpu;
+};
+
+// Steady-state check: after the warm-up every frame of the render thread has to be free of heap
+// allocations. Frames that allocate are counted and their allocations attributed to the
+// innermost profiler zone that made them.
+class AllocationCheck {
+public:
+    AllocationCheck() {
+        m_zones.reserve(64);
+    }
+
+    void start(unsigned int frames, unsigned int warmupFrames = 120) {
+        m_warmupFrames = warmupFrames;
+        m_totalFrames = warmupFrames + frames;
+        m_frame = 0;
+        m_allocatingFrames = 0;
+        m_allocations = 0;
+        m_maxAllocations = 0;
+        m_bytes = 0;
+        m_zones.clear();
+        m_running = frames > 0;
+    }
+
+    bool running() const {
+        return m_running && m_frame < m_totalFrames;
+    }
+
+    bool finished() const {
+        return m_running && m_frame >= m_totalFrames;
+    }
+
+    // call first thing in the frame, before the other beginFrame() calls, so that what they
+    // allocate, e.g. a frame arena that grows, is counted too; it shows up outside the zones
+    void beginFrame() {
+        m_frameStart = threadAllocations();
+    }
+
+    // zones are the profiler zones of the frame that just ended
+    void endFrame(const std::vector<ProfileZoneSample> &zones) {
+        AllocationCounters now = threadAllocations();
+        uint64_t allocations = now.allocations - m_frameStart.allocations;
+        if (m_frame++ < m_warmupFrames || allocations == 0)
+            return;
+        ++m_allocatingFrames;
+        m_allocations += allocations;
+        m_bytes += now.bytes - m_frameStart.bytes;
+        if (allocations > m_maxAllocations)
+            m_maxAllocations = allocations;
+
+        // allocations of a zone minus those of the zones inside it
+        uint64_t attributed = 0;
+        for (size_t i = 0; i < zones.size(); ++i) {
+            uint64_t self = zones[i].allocations;
+            for (size_t child = i + 1; child < zones.size() && zones[child].depth > zones[i].depth; ++child)
+                if (zones[child].depth == zones[i].depth + 1)
+                    self -= zones[child].allocations;
+            if (zones[i].depth == 0)
+                attributed += zones[i].allocations;
+            addZone(zones[i].name, self);
+        }
+        addZone("(outside zones)", allocations - attributed);
+    }
+
+    bool passed() const {
+        return m_allocatingFrames == 0;
+    }
+
+    void report(std::ostream &out) const {
+        unsigned int measured = m_totalFrames - m_warmupFrames;
+        char line[160];
+        std::snprintf(line, sizeof(line),
+                      "Allocation check: %u of %u frames allocated, %llu allocations, %llu bytes, at most %llu "
+                      "in one frame\n",
+                      m_allocatingFrames, measured, (unsigned long long) m_allocations,
+                      (unsigned long long) m_bytes, (unsigned long long) m_maxAllocations);
+        out << line;
+        for (const Zone &zone : m_zones) {
+            std::snprintf(line, sizeof(line), "  %10llu  %s\n", (unsigned long long) zone.allocations, zone.name);
+            out << line;
+        }
+    }
+
+private:
+    struct Zone {
+        const char *name;
+        uint64_t allocations;
+    };
+
+    void addZone(const char *name, uint64_t allocations) {
+        if (allocations == 0)
+            return;
+        for (Zone &zone : m_zones) {
+            if (zone.name == name) {
+                zone.allocations += allocations;
+                return;
+            }
+        }
+        m_zones.push_back(Zone{name, allocations});
+    }
+
+    unsigned int m_warmupFrames = 0;
+    unsigned int m_totalFrames = 0;
+    unsigned int m_frame = 0;
+    bool m_running = false;
+    AllocationCounters m_frameStart = {0, 0};
+    unsigned int m_allocatingFrames = 0;
+    uint64_t m_allocations = 0;
+    uint64_t m_maxAllocations = 0;
+    uint64_t m_bytes = 0;
+    std::vector<Zone> m_zones;
+};
+
+enum PageCacheEviction {
+    // the whole page cache was dropped, needs root
+    PAGE_CACHE_DROPPED,
+    // only the given files and the mapped libraries were evicted; pages other processes, or
+    // this one, have mapped stay cached
+    PAGE_CACHE_FILES_EVICTED,
+    PAGE_CACHE_NOT_EVICTED
+};
+
+class StartupBenchmark {
+public:
+    // command starts one run that prints StartupTimeline::write() after its first frame and
+    // exits; evictPaths are the files and directories a cold run must read from disk
+    StartupBenchmark(const std::string &command, const std::vector<std::string> &evictPaths)
+            : m_command(command), m_evictPaths(evictPaths) {
+    }
+
+    // cold and warm runs alternate, so both see the same system load
+    bool run(unsigned int pairs) {
+        for (unsigned int i = 0; i < pairs; ++i) {
+            m_eviction = evictFromPageCache(m_evictPaths);
+            if (!launch(m_cold) || !launch(m_warm))
+                return false;
+        }
+        return true;
+    }
+
+    void report(std::ostream &out) const {
+        const char *eviction = m_eviction == PAGE_CACHE_DROPPED ? "page cache dropped" :
+                               m_eviction == PAGE_CACHE_FILES_EVICTED ? "game files evicted from the page cache" :
+                               "page cache not evicted, cold runs are warm";
+        out << "Startup benchmark: " << m_cold.runs << " cold and " << m_warm.runs << " warm runs, " << eviction
+            << '\n';
+        out << "     cold      warm  (ms, mean)\n";
+        for (size_t i = 0; i < m_names.size(); ++i) {
+            char line[256];
+            std::snprintf(line, sizeof(line), "%9.3f %9.3f  %*s%s\n", m_cold.mean(i), m_warm.mean(i),
+                          m_depths[i] * 2, "", m_names[i].c_str());
+            out << line;
+        }
+    }
+
+    // tries to drop the whole page cache, otherwise evicts the files under paths and every
+    // library this process has mapped, i.e. the same ones a launched run loads
+    static PageCacheEviction evictFromPageCache(const std::vector<std::string> &paths) {
+#ifdef __linux__
+        sync();
+        {
+            std::ofstream dropCaches("/proc/sys/vm/drop_caches");
+            if (dropCaches << "3" << std::flush)
+                return PAGE_CACHE_DROPPED;
+        }
+        bool evicted = false;
+        for (const std::string &path : paths)
+            evicted |= evictPath(path);
+        std::ifstream maps("/proc/self/maps");
+        std::string line;
+        while (std::getline(maps, line)) {
+            size_t file = line.find('/');
+            if (file != std::string::npos)
+                evictFile(line.substr(file));
+        }
+        return evicted ? PAGE_CACHE_FILES_EVICTED : PAGE_CACHE_NOT_EVICTED;
+#else
+        return PAGE_CACHE_NOT_EVICTED;
+#endif
+    }
+
+private:
+    struct Runs {
+        unsigned int runs = 0;
+        std::vector<double> sums;
+
+        double mean(size_t phase) const {
+            return runs == 0 || phase >= sums.size() ? 0.0 : sums[phase] / runs;
+        }
+    };
+
+    bool launch(Runs &runs) {
+        std::FILE *pipe = popen(m_command.c_str(), "r");
+        if (!pipe)
+            return false;
+        std::string output;
+        char buffer[4096];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+            output.append(buffer, read);
+        if (pclose(pipe) != 0)
+            return false;
+
+        std::istringstream in(output);
+        std::vector<StartupPhase> phases = StartupTimeline::read(in);
+        if (phases.empty())
+            return false;
+        ++runs.runs;
+        for (const StartupPhase &phase : phases) {
+            size_t index = std::find(m_names.begin(), m_names.end(), phase.name) - m_names.begin();
+            if (index == m_names.size()) {
+                m_names.push_back(phase.name);
+                m_depths.push_back(phase.depth);
+            }
+            if (runs.sums.size() <= index)
+                runs.sums.resize(index + 1, 0.0);
+            runs.sums[index] += phase.milliseconds;
+        }
+        return true;
+    }
+
+#ifdef __linux__
+    static bool evictFile(const std::string &path) {
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+        bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        close(file);
+        return evicted;
+    }
+
+    static bool evictPath(const std::string &path) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+        if (!S_ISDIR(info.st_mode))
+            return evictFile(path);
+        DIR *directory = opendir(path.c_str());
+        if (!directory)
+            return false;
+        bool evicted = false;
+        while (dirent *entry = readdir(directory)) {
+            if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0)
+                evicted |= evictPath(path + '/' + entry->d_name);
+        }
+        closedir(directory);
+        return evicted;
+    }
+#endif
+
+    std::string m_command;
+    std::vector<std::string> m_evictPaths;
+    PageCacheEviction m_eviction = PAGE_CACHE_NOT_EVICTED;
+    // phases in the order they first appeared, "total" is one of them
+    std::vector<std::string> m_names;
+    std::vector<int> m_depths;
+    Runs m_cold;
+    Runs m_warm;
+};
+
+};
+
+#endif //PROJECT_BASE_BENCHMARK_H
@@ -18,7 +18,8 @@
 float RandomPosition()
 {
     float positions[] = {-0.5,0.0, 0.5};
-    std::default_random_engine generator( std::random_device{}() );
+    // seeded once; a random_device per spawned cube was a system call in the middle of the frame
+    static std::default_random_engine generator( std::random_device{}() );
     std::uniform_int_distribution<int> distribution(0,2);
     int index = distribution(generator);
     //std::cerr << index << std::endl;
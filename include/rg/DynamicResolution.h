@@ -0,0 +1,91 @@
+//
+// Dynamic resolution: picks the scale the scene is rendered at, relative to the window, from
+// measured GPU frame times. GPU cost grows with the pixel count, i.e. with the square of the scale,
+// so the controller steps the scale by the square root of the target/measured ratio.
+//
+
+#ifndef PROJECT_BASE_DYNAMICRESOLUTION_H
+#define PROJECT_BASE_DYNAMICRESOLUTION_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rg {
+
+struct DynamicResolutionSettings {
+    bool enabled = true;
+    // GPU budget of one frame; a bit under the 16.7 ms of 60 Hz, the CPU and the compositor need some too
+    float targetMilliseconds = 14.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // strength of the sharpening in the upscale, 0 turns it off
+    float sharpness = 0.5f;
+};
+
+class DynamicResolution {
+public:
+    // one GPU time per frame, in the order the frames were rendered
+    void addSample(const DynamicResolutionSettings &settings, double milliseconds) {
+        if (!settings.enabled) {
+            m_scale = 1.0f;
+            m_samples = 0;
+            return;
+        }
+        // frames rendered before the last change are still arriving, they say nothing about the new scale
+        if (m_skip > 0) {
+            --m_skip;
+            return;
+        }
+        m_average = m_samples == 0 ? milliseconds : m_average + (milliseconds - m_average) * SMOOTHING;
+        if (++m_samples < MIN_SAMPLES)
+            return;
+
+        // between 85% and 100% of the budget the scale is left alone, so it does not oscillate
+        double target = settings.targetMilliseconds;
+        if (m_average > target || m_average < target * 0.85) {
+            float step = (float) std::sqrt(target * 0.95 / m_average);
+            step = std::min(std::max(step, 1.0f - MAX_STEP), 1.0f + MAX_STEP);
+            float scale = std::min(std::max(m_scale * step, settings.minScale), settings.maxScale);
+            if (std::abs(scale - m_scale) > 0.005f) {
+                m_scale = scale;
+                m_skip = LATENCY_FRAMES;
+                m_samples = 0;
+            }
+        }
+    }
+
+    float scale() const {
+        return m_scale;
+    }
+
+    // size the scene is rendered at, rounded to 8 pixels so the scale moves in coarse steps
+    glm::ivec2 renderSize(int width, int height) const {
+        auto scaled = [this](int size) {
+            int pixels = (int) std::ceil(size * m_scale / 8.0f) * 8;
+            return std::max(std::min(pixels, size), 1);
+        };
+        return glm::ivec2(scaled(width), scaled(height));
+    }
+
+    double averageMilliseconds() const {
+        return m_average;
+    }
+
+private:
+    static constexpr double SMOOTHING = 0.2;
+    static constexpr float MAX_STEP = 0.1f;
+    // GPU timer results lag a few frames behind
+    static const int LATENCY_FRAMES = 4;
+    static const int MIN_SAMPLES = 6;
+
+    float m_scale = 1.0f;
+    double m_average = 0.0;
+    int m_samples = 0;
+    int m_skip = 0;
+};
+
+};
+
+#endif //PROJECT_BASE_DYNAMICRESOLUTION_H
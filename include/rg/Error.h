@@ -11,8 +11,26 @@
 #define LOG(stream) stream << "[" << __FILE__ << ", " << __func__ << ", " << __LINE__ << "] "
 #define BREAK_IF_FALSE(x) if (!(x)) __builtin_trap()
 #define ASSERT(x, msg) do { if (!(x)) { std::cerr << msg << '\n'; BREAK_IF_FALSE(false); } } while(0)
+
+// How OpenGL errors are caught, chosen at compile time with -DRG_GL_CHECKS=...:
+//   RG_GL_CHECKS_OFF       nothing is checked
+//   RG_GL_CHECKS_CALLBACK  the driver reports errors through the KHR_debug callback (rg/GLDebug.h)
+//                          and GLCALL adds nothing; cheap enough to stay on in release builds
+//   RG_GL_CHECKS_SYNC      the callback runs synchronously and GLCALL also drains glGetError around
+//                          the wrapped call; stalls on every call, for hunting down one error
+#define RG_GL_CHECKS_OFF 0
+#define RG_GL_CHECKS_CALLBACK 1
+#define RG_GL_CHECKS_SYNC 2
+#ifndef RG_GL_CHECKS
+#define RG_GL_CHECKS RG_GL_CHECKS_CALLBACK
+#endif
+
+#if RG_GL_CHECKS == RG_GL_CHECKS_SYNC
 #define GLCALL(x) \
 do{ rg::clearAllOpenGlErrors(); x; BREAK_IF_FALSE(rg::wasPreviousOpenGLCallSuccessful(__FILE__, __LINE__, #x)); } while (0)
+#else
+#define GLCALL(x) do { x; } while (0)
+#endif
 
 namespace rg {
 
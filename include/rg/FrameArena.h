@@ -0,0 +1,196 @@
+//
+// Frame arena: a double-buffered bump allocator for data that lives at most one frame, e.g. sort
+// scratch and culling results. beginFrame() switches to the other buffer and resets it, so what
+// the previous frame allocated stays valid until the end of this one. Freeing is a no-op. When a
+// frame needs more than the capacity the rest comes from the heap and the buffer grows to fit the
+// next time it is reset, so after a few frames a steady scene allocates nothing.
+//
+// FrameAllocator lets standard containers use the arena; such a container must not outlive the
+// frame after the one it was created in.
+//
+
+#ifndef PROJECT_BASE_FRAMEARENA_H
+#define PROJECT_BASE_FRAMEARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace rg {
+
+class FrameArena {
+public:
+    static const size_t DEFAULT_CAPACITY = 1 << 20;
+
+    // capacity of each of the two buffers
+    explicit FrameArena(size_t capacity = DEFAULT_CAPACITY) {
+        for (Buffer &buffer : m_buffers)
+            buffer.resize(capacity);
+    }
+
+    ~FrameArena() {
+        for (Buffer &buffer : m_buffers)
+            buffer.releaseOverflow();
+    }
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    // everything allocated two frames ago is released; call once at the start of every frame
+    void beginFrame() {
+        m_lastFrameBytes = m_buffers[m_current].usedBytes();
+        m_current ^= 1;
+        Buffer &buffer = m_buffers[m_current];
+        buffer.releaseOverflow();
+        // grow to the largest frame seen, in whole powers of two so growth settles quickly
+        if (m_highWaterBytes > buffer.capacity) {
+            size_t capacity = std::max<size_t>(buffer.capacity, 1);
+            while (capacity < m_highWaterBytes)
+                capacity *= 2;
+            buffer.resize(capacity);
+        }
+        buffer.offset = 0;
+    }
+
+    // alignment is a power of two, at most alignof(std::max_align_t)
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        Buffer &buffer = m_buffers[m_current];
+        uintptr_t base = (uintptr_t) buffer.memory.get();
+        uintptr_t start = (base + buffer.offset + alignment - 1) & ~(uintptr_t) (alignment - 1);
+        size_t end = (size_t) (start - base) + bytes;
+        void *memory;
+        if (end <= buffer.capacity) {
+            buffer.offset = end;
+            memory = (void *) start;
+        } else {
+            memory = ::operator new(bytes);
+            buffer.overflow.push_back(memory);
+            buffer.overflowBytes += bytes;
+            ++m_overflows;
+        }
+        m_highWaterBytes = std::max(m_highWaterBytes, buffer.usedBytes());
+        return memory;
+    }
+
+    template<typename T>
+    T *allocateArray(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_alloc();
+        return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // bytes the frame being recorded has taken so far, overflow included
+    size_t usedBytes() const {
+        return m_buffers[m_current].usedBytes();
+    }
+
+    size_t lastFrameBytes() const {
+        return m_lastFrameBytes;
+    }
+
+    // most any frame has taken
+    size_t highWaterBytes() const {
+        return m_highWaterBytes;
+    }
+
+    // of the buffer in use
+    size_t capacity() const {
+        return m_buffers[m_current].capacity;
+    }
+
+    // allocations that did not fit and went to the heap, since the start
+    unsigned int overflows() const {
+        return m_overflows;
+    }
+
+private:
+    struct Buffer {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t capacity = 0;
+        size_t offset = 0;
+        std::vector<void *> overflow;
+        size_t overflowBytes = 0;
+
+        void resize(size_t bytes) {
+            memory.reset(new unsigned char[bytes]);
+            capacity = bytes;
+        }
+
+        void releaseOverflow() {
+            for (void *memory : overflow)
+                ::operator delete(memory);
+            overflow.clear();
+            overflowBytes = 0;
+        }
+
+        size_t usedBytes() const {
+            return offset + overflowBytes;
+        }
+    };
+
+    Buffer m_buffers[2];
+    int m_current = 0;
+    size_t m_lastFrameBytes = 0;
+    size_t m_highWaterBytes = 0;
+    unsigned int m_overflows = 0;
+};
+
+// the arena of the render thread
+inline FrameArena &frameArena() {
+    static FrameArena arena;
+    return arena;
+}
+
+template<typename T>
+class FrameAllocator {
+public:
+    typedef T value_type;
+
+    FrameAllocator() noexcept
+            : m_arena(&frameArena()) {
+    }
+
+    explicit FrameAllocator(FrameArena &arena) noexcept
+            : m_arena(&arena) {
+    }
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U> &other) noexcept
+            : m_arena(other.arena()) {
+    }
+
+    T *allocate(size_t count) {
+        return m_arena->allocateArray<T>(count);
+    }
+
+    void deallocate(T *, size_t) noexcept {
+    }
+
+    FrameArena *arena() const noexcept {
+        return m_arena;
+    }
+
+private:
+    FrameArena *m_arena;
+};
+
+template<typename T, typename U>
+bool operator==(const FrameAllocator<T> &a, const FrameAllocator<U> &b) noexcept {
+    return a.arena() == b.arena();
+}
+
+template<typename T, typename U>
+bool operator!=(const FrameAllocator<T> &a, const FrameAllocator<U> &b) noexcept {
+    return a.arena() != b.arena();
+}
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+};
+
+#endif //PROJECT_BASE_FRAMEARENA_H
@@ -0,0 +1,314 @@
+//
+// Frame capture for recordings. Every frame the finished image is copied into one buffer of a
+// ring of pixel buffers, with a fence behind the copy; a buffer is mapped only once its fence has
+// signalled, i.e. a frame or so later, so the GPU never drains and the CPU never waits for it.
+// Converting and writing the frames happens on a worker thread. When the ring or the worker's
+// queue is full the frame is dropped instead of stalling the game.
+//
+// GL 3.3 has no persistently mapped buffers and a context belongs to one thread, so the mapping
+// itself stays on the render thread: it copies out of signalled buffers only, everything slow is
+// on the worker.
+//
+
+#ifndef PROJECT_BASE_FRAMECAPTURE_H
+#define PROJECT_BASE_FRAMECAPTURE_H
+
+#include <glad/glad.h>
+
+#include <rg/GLState.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+enum CaptureFormat {
+    // one file, YUV 4:4:4 frames; plays in mpv and converts with ffmpeg
+    CAPTURE_Y4M,
+    // one RGB file per frame, <path>_000000.ppm
+    CAPTURE_PPM
+};
+
+class FrameCapture {
+public:
+    static const unsigned int BUFFERS = 3;
+    // frames converted images may wait for the writer before new ones are dropped
+    static const size_t MAX_QUEUED = 8;
+
+    FrameCapture() {
+        glGenBuffers(BUFFERS, m_buffers);
+        for (Readback &readback : m_readbacks)
+            readback = Readback();
+    }
+
+    ~FrameCapture() {
+        stop();
+        glDeleteBuffers(BUFFERS, m_buffers);
+    }
+
+    FrameCapture(const FrameCapture &) = delete;
+    FrameCapture &operator=(const FrameCapture &) = delete;
+
+    bool start(const std::string &path, CaptureFormat format, int framesPerSecond = 60) {
+        stop();
+        if (format == CAPTURE_Y4M) {
+            m_file = std::fopen(path.c_str(), "wb");
+            if (!m_file)
+                return false;
+        }
+        m_path = path;
+        m_format = format;
+        m_framesPerSecond = framesPerSecond;
+        m_width = 0;
+        m_height = 0;
+        m_captured = 0;
+        m_dropped = 0;
+        m_written = 0;
+        m_queued = 0;
+        m_stopping = false;
+        m_recording = true;
+        m_writer = std::thread(&FrameCapture::writerLoop, this);
+        return true;
+    }
+
+    // waits for the frames still in flight and for the writer, so the file is complete afterwards
+    void stop() {
+        if (!m_recording)
+            return;
+        collect(true);
+        // only if the GPU did not finish within the timeout
+        for (; m_pending > 0; --m_pending) {
+            Readback &readback = m_readbacks[(m_next + BUFFERS - m_pending) % BUFFERS];
+            glDeleteSync(readback.fence);
+            readback.fence = 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_writer.join();
+        if (m_file) {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+        m_recording = false;
+    }
+
+    bool recording() const {
+        return m_recording;
+    }
+
+    // copies the bottom-left width x height pixels of the default framebuffer; call after the
+    // last pass of the image and before the UI is drawn
+    void capture(int width, int height) {
+        if (!m_recording)
+            return;
+        collect(false);
+        // a Y4M stream has one size for all frames
+        if (m_format == CAPTURE_Y4M && m_width != 0 && (width != m_width || height != m_height)) {
+            std::fprintf(stderr, "Frame capture: the window size changed, recording stopped\n");
+            stop();
+            return;
+        }
+        m_width = width;
+        m_height = height;
+        if (m_pending == BUFFERS) {
+            ++m_dropped;
+            return;
+        }
+
+        Readback &readback = m_readbacks[m_next];
+        size_t bytes = (size_t) width * height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[m_next]);
+        if (readback.bytes != bytes) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+            readback.bytes = bytes;
+        }
+        glState().bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.width = width;
+        readback.height = height;
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_next = (m_next + 1) % BUFFERS;
+        ++m_pending;
+        ++m_captured;
+    }
+
+    unsigned int capturedFrames() const {
+        return m_captured;
+    }
+
+    unsigned int droppedFrames() const {
+        return m_dropped;
+    }
+
+    unsigned int writtenFrames() const {
+        return m_written;
+    }
+
+private:
+    struct Readback {
+        GLsync fence = 0;
+        size_t bytes = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // RGBA rows bottom-up, as glReadPixels returns them
+    struct Frame {
+        std::vector<uint8_t> pixels;
+        int width;
+        int height;
+        unsigned int index;
+    };
+
+    // hands every finished readback to the writer, oldest first
+    void collect(bool wait) {
+        while (m_pending > 0) {
+            unsigned int oldest = (m_next + BUFFERS - m_pending) % BUFFERS;
+            Readback &readback = m_readbacks[oldest];
+            GLenum status = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                             wait ? 1000000000ull : 0);
+            if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+                return;
+            glDeleteSync(readback.fence);
+            readback.fence = 0;
+            --m_pending;
+
+            Frame frame;
+            frame.width = readback.width;
+            frame.height = readback.height;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_queue.size() >= MAX_QUEUED) {
+                    ++m_dropped;
+                    continue;
+                }
+                if (!m_free.empty()) {
+                    frame.pixels = std::move(m_free.back());
+                    m_free.pop_back();
+                }
+                frame.index = m_queued++;
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[oldest]);
+            const void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.bytes, GL_MAP_READ_BIT);
+            if (pixels) {
+                frame.pixels.resize(readback.bytes);
+                std::memcpy(frame.pixels.data(), pixels, readback.bytes);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            } else {
+                frame.pixels.assign(readback.bytes, 0);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queue.push_back(std::move(frame));
+            }
+            m_wake.notify_one();
+        }
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+            if (m_queue.empty())
+                return;
+            Frame frame = std::move(m_queue.front());
+            m_queue.pop_front();
+            lock.unlock();
+
+            if (m_format == CAPTURE_Y4M)
+                writeY4m(frame);
+            else
+                writePpm(frame);
+            ++m_written;
+
+            lock.lock();
+            m_free.push_back(std::move(frame.pixels));
+        }
+    }
+
+    // BT.601 studio range, what players assume for Y4M without a color tag
+    void writeY4m(const Frame &frame) {
+        if (frame.index == 0)
+            std::fprintf(m_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", frame.width, frame.height,
+                         m_framesPerSecond);
+        size_t pixels = (size_t) frame.width * frame.height;
+        m_planes.resize(pixels * 3);
+        uint8_t *y = m_planes.data(), *u = y + pixels, *v = u + pixels;
+        for (int row = 0; row < frame.height; ++row) {
+            const uint8_t *rgba = frame.pixels.data() + (size_t) (frame.height - 1 - row) * frame.width * 4;
+            for (int column = 0; column < frame.width; ++column, rgba += 4) {
+                int r = rgba[0], g = rgba[1], b = rgba[2];
+                *y++ = (uint8_t) (((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                *u++ = (uint8_t) (((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                *v++ = (uint8_t) (((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+        std::fputs("FRAME\n", m_file);
+        std::fwrite(m_planes.data(), 1, m_planes.size(), m_file);
+    }
+
+    void writePpm(const Frame &frame) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "_%06u.ppm", frame.index);
+        std::FILE *file = std::fopen((m_path + name).c_str(), "wb");
+        if (!file)
+            return;
+        std::fprintf(file, "P6\n%d %d\n255\n", frame.width, frame.height);
+        m_planes.resize((size_t) frame.width * 3);
+        for (int row = frame.height - 1; row >= 0; --row) {
+            const uint8_t *rgba = frame.pixels.data() + (size_t) row * frame.width * 4;
+            for (int column = 0; column < frame.width; ++column) {
+                m_planes[column * 3] = rgba[column * 4];
+                m_planes[column * 3 + 1] = rgba[column * 4 + 1];
+                m_planes[column * 3 + 2] = rgba[column * 4 + 2];
+            }
+            std::fwrite(m_planes.data(), 1, m_planes.size(), file);
+        }
+        std::fclose(file);
+    }
+
+    GLuint m_buffers[BUFFERS];
+    Readback m_readbacks[BUFFERS];
+    unsigned int m_next = 0;
+    unsigned int m_pending = 0;
+
+    std::string m_path;
+    CaptureFormat m_format = CAPTURE_Y4M;
+    int m_framesPerSecond = 60;
+    std::FILE *m_file = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    bool m_recording = false;
+    unsigned int m_captured = 0;
+    unsigned int m_dropped = 0;
+    std::atomic<unsigned int> m_written{0};
+
+    // shared with the writer
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Frame> m_queue;
+    std::vector<std::vector<uint8_t>> m_free;
+    unsigned int m_queued = 0;
+    bool m_stopping = false;
+    // conversion scratch, only touched by the writer
+    std::vector<uint8_t> m_planes;
+};
+
+};
+
+#endif //PROJECT_BASE_FRAMECAPTURE_H
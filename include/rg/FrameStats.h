@@ -0,0 +1,198 @@
+//
+// Per-frame submission counters: draw calls, submitted vertices and triangles, binds, uniform
+// uploads, buffer upload bytes and frame arena use. Draws and uploads are counted by thin
+// wrappers around the GL calls, binds come from the GLState counters. The last HISTORY frames
+// are kept for plotting.
+//
+
+#ifndef PROJECT_BASE_FRAMESTATS_H
+#define PROJECT_BASE_FRAMESTATS_H
+
+#include <glad/glad.h>
+
+#include <rg/GLState.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <vector>
+
+namespace rg {
+
+struct FrameStats {
+    unsigned int drawCalls = 0;
+    // vertices the draws submit, indices for indexed draws
+    uint64_t vertices = 0;
+    uint64_t triangles = 0;
+    unsigned int programBinds = 0;
+    unsigned int vertexArrayBinds = 0;
+    unsigned int textureBinds = 0;
+    unsigned int uniformUploads = 0;
+    uint64_t bufferUploadBytes = 0;
+    unsigned int culledObjects = 0;
+    // taken from the frame arena, heap overflow included
+    uint64_t arenaBytes = 0;
+};
+
+inline uint64_t trianglesOf(GLenum mode, uint64_t vertices) {
+    switch (mode) {
+        case GL_TRIANGLES: return vertices / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN: return vertices >= 3 ? vertices - 2 : 0;
+        default: return 0;
+    }
+}
+
+// sums of the counters over any number of frames, e.g. every frame a benchmark mode rendered
+class FrameStatsTotals {
+public:
+    void add(const FrameStats &frame) {
+        const double values[COUNTERS] = {(double) frame.drawCalls, (double) frame.vertices, (double) frame.triangles,
+                                         (double) frame.programBinds, (double) frame.vertexArrayBinds,
+                                         (double) frame.textureBinds, (double) frame.uniformUploads,
+                                         (double) frame.bufferUploadBytes, (double) frame.culledObjects,
+                                         (double) frame.arenaBytes};
+        for (int i = 0; i < COUNTERS; ++i)
+            m_sums[i] += values[i];
+        m_arenaPeak = std::max(m_arenaPeak, frame.arenaBytes);
+        ++m_frames;
+    }
+
+    size_t frames() const {
+        return m_frames;
+    }
+
+    // mean of every counter, and the largest frame arena use
+    void report(std::ostream &out, const char *label) const {
+        double frames = m_frames == 0 ? 1.0 : (double) m_frames;
+        const double *sums = m_sums;
+        char line[400];
+        std::snprintf(line, sizeof(line),
+                      "%s, mean of %zu frames: %.1f draws, %.0f vertices, %.0f triangles, "
+                      "%.1f program / %.1f VAO / %.1f texture binds, %.1f uniforms, %.0f upload bytes, "
+                      "%.1f culled, %.1f KiB frame arena (peak %.1f KiB)\n",
+                      label, m_frames, sums[0] / frames, sums[1] / frames, sums[2] / frames, sums[3] / frames,
+                      sums[4] / frames, sums[5] / frames, sums[6] / frames, sums[7] / frames, sums[8] / frames,
+                      sums[9] / frames / 1024.0, m_arenaPeak / 1024.0);
+        out << line;
+    }
+
+private:
+    static const int COUNTERS = 10;
+
+    double m_sums[COUNTERS] = {};
+    uint64_t m_arenaPeak = 0;
+    size_t m_frames = 0;
+};
+
+class FrameStatsRecorder {
+public:
+    static const unsigned int HISTORY = 240;
+
+    FrameStatsRecorder() {
+        m_history.reserve(HISTORY);
+    }
+
+    // closes the frame that was being counted, with the binds GLState counted for it; call right
+    // after glState().beginFrame()
+    void beginFrame(const GLState::Counters &stateCounters) {
+        m_current.programBinds = stateCounters.programBinds;
+        m_current.vertexArrayBinds = stateCounters.vertexArrayBinds;
+        m_current.textureBinds = stateCounters.textureBinds;
+        if (m_history.size() < HISTORY)
+            m_history.push_back(m_current);
+        else
+            m_history[m_next] = m_current;
+        m_next = (m_next + 1) % HISTORY;
+        m_current = FrameStats();
+    }
+
+    // counters of the frame being rendered
+    FrameStats &current() {
+        return m_current;
+    }
+
+    // the frame being rendered, with the binds GLState has counted for it so far
+    FrameStats snapshot(const GLState::Counters &stateCounters) const {
+        FrameStats stats = m_current;
+        stats.programBinds = stateCounters.programBinds;
+        stats.vertexArrayBinds = stateCounters.vertexArrayBinds;
+        stats.textureBinds = stateCounters.textureBinds;
+        return stats;
+    }
+
+    void countDraw(GLenum mode, uint64_t vertices, unsigned int calls = 1) {
+        m_current.drawCalls += calls;
+        m_current.vertices += vertices;
+        m_current.triangles += trianglesOf(mode, vertices);
+    }
+
+    void countUniform() {
+        ++m_current.uniformUploads;
+    }
+
+    void countUpload(uint64_t bytes) {
+        m_current.bufferUploadBytes += bytes;
+    }
+
+    size_t historySize() const {
+        return m_history.size();
+    }
+
+    // 0 is the oldest recorded frame
+    const FrameStats &history(size_t index) const {
+        return m_history.size() < HISTORY ? m_history[index] : m_history[(m_next + index) % HISTORY];
+    }
+
+    // the last finished frame
+    const FrameStats &lastFrame() const {
+        static const FrameStats empty;
+        return m_history.empty() ? empty : history(m_history.size() - 1);
+    }
+
+    // mean of every counter over the recorded history, and the largest frame arena use
+    void report(std::ostream &out) const {
+        FrameStatsTotals totals;
+        for (const FrameStats &frame : m_history)
+            totals.add(frame);
+        totals.report(out, "Frame stats");
+    }
+
+private:
+    FrameStats m_current;
+    std::vector<FrameStats> m_history;
+    size_t m_next = 0;
+};
+
+// everything that draws or uploads counts into this instance
+inline FrameStatsRecorder &frameStats() {
+    static FrameStatsRecorder recorder;
+    return recorder;
+}
+
+inline void drawArrays(GLenum mode, GLint first, GLsizei count) {
+    frameStats().countDraw(mode, (uint64_t) count);
+    glDrawArrays(mode, first, count);
+}
+
+inline void drawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+    frameStats().countDraw(mode, (uint64_t) count);
+    glDrawElements(mode, count, type, indices);
+}
+
+// uploads without data only allocate and are not counted
+inline void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+    if (data)
+        frameStats().countUpload((uint64_t) size);
+    glBufferData(target, size, data, usage);
+}
+
+inline void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+    frameStats().countUpload((uint64_t) size);
+    glBufferSubData(target, offset, size, data);
+}
+
+};
+
+#endif //PROJECT_BASE_FRAMESTATS_H
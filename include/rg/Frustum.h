@@ -0,0 +1,118 @@
+//
+// View-frustum culling of bounding spheres, four spheres per iteration with SSE.
+//
+
+#ifndef PROJECT_BASE_FRUSTUM_H
+#define PROJECT_BASE_FRUSTUM_H
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define RG_FRUSTUM_SSE 1
+#endif
+
+namespace rg {
+
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// xyz is the center, w the radius
+typedef glm::vec4 BoundingSphere;
+
+inline BoundingSphere sphereFromAABB(const AABB &box) {
+    glm::vec3 center = (box.min + box.max) * 0.5f;
+    return BoundingSphere(center, glm::length(box.max - center));
+}
+
+// moves a local sphere into world space; the radius grows with the largest axis scale of the transform
+inline BoundingSphere transformSphere(const glm::mat4 &model, const BoundingSphere &sphere) {
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+    float scaleX = glm::dot(glm::vec3(model[0]), glm::vec3(model[0]));
+    float scaleY = glm::dot(glm::vec3(model[1]), glm::vec3(model[1]));
+    float scaleZ = glm::dot(glm::vec3(model[2]), glm::vec3(model[2]));
+    float maxScale = std::sqrt(glm::max(scaleX, glm::max(scaleY, scaleZ)));
+    return BoundingSphere(center, sphere.w * maxScale);
+}
+
+class Frustum {
+public:
+    // planes of projection * view, normals pointing inwards
+    explicit Frustum(const glm::mat4 &viewProjection) {
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+        glm::vec4 planes[6] = {
+                rows[3] + rows[0], rows[3] - rows[0],   // left, right
+                rows[3] + rows[1], rows[3] - rows[1],   // bottom, top
+                rows[3] + rows[2], rows[3] - rows[2]    // near, far
+        };
+        for (int i = 0; i < 6; ++i) {
+            float length = glm::length(glm::vec3(planes[i]));
+            planes[i] = planes[i] / length;
+            m_x[i] = planes[i].x;
+            m_y[i] = planes[i].y;
+            m_z[i] = planes[i].z;
+            m_w[i] = planes[i].w;
+        }
+    }
+
+    bool isVisible(const BoundingSphere &sphere) const {
+        for (int i = 0; i < 6; ++i) {
+            float distance = m_x[i] * sphere.x + m_y[i] * sphere.y + m_z[i] * sphere.z + m_w[i];
+            if (distance < -sphere.w)
+                return false;
+        }
+        return true;
+    }
+
+    // writes 1 for every sphere that intersects the frustum and 0 otherwise, returns the number culled
+    size_t cullSpheres(const BoundingSphere *spheres, size_t count, uint8_t *visible) const {
+        size_t culled = 0;
+        size_t i = 0;
+#ifdef RG_FRUSTUM_SSE
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(&spheres[i].x);
+            __m128 y = _mm_loadu_ps(&spheres[i + 1].x);
+            __m128 z = _mm_loadu_ps(&spheres[i + 2].x);
+            __m128 r = _mm_loadu_ps(&spheres[i + 3].x);
+            // AoS -> SoA: x holds the four centers' x, ..., r the four radii
+            _MM_TRANSPOSE4_PS(x, y, z, r);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+
+            __m128 inside = _mm_cmpeq_ps(r, r);
+            for (int p = 0; p < 6; ++p) {
+                __m128 distance = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m_x[p]), x), _mm_mul_ps(_mm_set1_ps(m_y[p]), y)),
+                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m_z[p]), z), _mm_set1_ps(m_w[p])));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+
+            int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; ++lane) {
+                visible[i + lane] = (mask >> lane) & 1;
+                culled += !visible[i + lane];
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            visible[i] = isVisible(spheres[i]);
+            culled += !visible[i];
+        }
+        return culled;
+    }
+
+private:
+    // plane equations stored per component
+    float m_x[6], m_y[6], m_z[6], m_w[6];
+};
+
+};
+
+#endif //PROJECT_BASE_FRUSTUM_H
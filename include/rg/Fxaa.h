@@ -0,0 +1,61 @@
+//
+// FXAA quality presets. The pass runs on the tonemapped image, which the final pass writes with
+// its luma in alpha; the number of edge search steps is compiled into the shader, so every preset
+// is its own program variant (see Fxaa::shaderDefines).
+//
+
+#ifndef PROJECT_BASE_FXAA_H
+#define PROJECT_BASE_FXAA_H
+
+#include <learnopengl/shader.h>
+
+#include <string>
+#include <vector>
+
+namespace rg {
+
+enum FxaaQuality {
+    FXAA_OFF = 0,
+    FXAA_LOW,
+    FXAA_MEDIUM,
+    FXAA_HIGH,
+    FXAA_QUALITY_COUNT
+};
+
+struct FxaaPreset {
+    const char *name;
+    // steps along the edge when searching for its ends, each a bit longer than the previous one
+    int searchSteps;
+    // minimum local contrast, relative to the brightest neighbour, that counts as an edge
+    float edgeThreshold;
+    // absolute contrast below which dark areas are skipped
+    float edgeThresholdMin;
+    // how much sub-pixel aliasing (thin lines, single pixels) is blurred away
+    float subpixel;
+};
+
+// indexed by FxaaQuality, FXAA_OFF only has a name
+const FxaaPreset FXAA_PRESETS[FXAA_QUALITY_COUNT] = {
+        {"Off", 0, 0.0f, 0.0f, 0.0f},
+        {"Low", 5, 0.250f, 0.0833f, 0.50f},
+        {"Medium", 8, 0.166f, 0.0625f, 0.75f},
+        {"High", 12, 0.125f, 0.0312f, 0.75f}
+};
+
+struct Fxaa {
+    static std::vector<std::string> shaderDefines(FxaaQuality quality) {
+        return {"FXAA_SEARCH_STEPS " + std::to_string(FXAA_PRESETS[quality].searchSteps)};
+    }
+
+    // the program has to be in use
+    static void setUniforms(const Shader &shader, FxaaQuality quality) {
+        const FxaaPreset &preset = FXAA_PRESETS[quality];
+        shader.setFloat("edgeThreshold", preset.edgeThreshold);
+        shader.setFloat("edgeThresholdMin", preset.edgeThresholdMin);
+        shader.setFloat("subpixel", preset.subpixel);
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_FXAA_H
@@ -0,0 +1,151 @@
+//
+// KHR_debug: driver messages arrive through a callback instead of glGetError polling, passes are
+// wrapped in debug groups and GL objects get labels, so GPU debuggers show names instead of
+// numbers. Everything is a no-op when the driver does not expose the extension. Whether the
+// callback is installed, and whether it runs synchronously, follows RG_GL_CHECKS from Error.h.
+//
+
+#ifndef PROJECT_BASE_GLDEBUG_H
+#define PROJECT_BASE_GLDEBUG_H
+
+#include <glad/glad.h>
+
+#include <rg/Error.h>
+#include <rg/GLExtensions.h>
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace rg {
+
+// the same message is printed only this many times, e.g. a performance warning every frame
+const unsigned int DEBUG_MESSAGE_REPEATS = 5;
+
+inline const char *debugSourceName(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API: return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+inline const char *debugTypeName(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        case GL_DEBUG_TYPE_MARKER: return "marker";
+        default: return "other";
+    }
+}
+
+inline const char *debugSeverityName(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW: return "low";
+        default: return "notification";
+    }
+}
+
+// asynchronous output may call this from a driver thread
+inline void APIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                          const GLchar *message, const void *) {
+    static std::mutex mutex;
+    // some drivers give every message of a kind the same id, the text tells them apart
+    static std::map<std::pair<GLuint, std::string>, unsigned int> repeats;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string text(message, length < 0 ? std::strlen(message) : (size_t) length);
+        unsigned int &count = repeats[std::make_pair(id, text)];
+        if (count == DEBUG_MESSAGE_REPEATS)
+            return;
+        std::cerr << "[OpenGL " << debugSeverityName(severity) << "] " << debugSourceName(source) << ' '
+                  << debugTypeName(type) << ' ' << id << ": " << message << '\n';
+        if (++count == DEBUG_MESSAGE_REPEATS)
+            std::cerr << "[OpenGL] the message above repeats, not printed anymore\n";
+    }
+#if RG_GL_CHECKS == RG_GL_CHECKS_SYNC
+    // synchronous output, the failing call is on the stack
+    if (type == GL_DEBUG_TYPE_ERROR)
+        BREAK_IF_FALSE(false);
+#endif
+}
+
+// installs the callback for messages of at least minSeverity: GL_DEBUG_SEVERITY_HIGH, _MEDIUM,
+// _LOW or _NOTIFICATION; false if checks are compiled out or the driver has no KHR_debug
+inline bool enableDebugOutput(GLenum minSeverity = GL_DEBUG_SEVERITY_MEDIUM) {
+#if RG_GL_CHECKS == RG_GL_CHECKS_OFF
+    (void) minSeverity;
+    return false;
+#else
+    const GLExtensions &ext = glExtensions();
+    if (!ext.debug)
+        return false;
+    glEnable(GL_DEBUG_OUTPUT);
+#if RG_GL_CHECKS == RG_GL_CHECKS_SYNC
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+    ext.DebugMessageCallback(debugMessageCallback, nullptr);
+
+    // everything off, then the severities from the most severe down to minSeverity back on
+    ext.DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    const GLenum severities[] = {GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW,
+                                 GL_DEBUG_SEVERITY_NOTIFICATION};
+    for (GLenum severity : severities) {
+        ext.DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, GL_TRUE);
+        if (severity == minSeverity)
+            break;
+    }
+    // the groups below would come back as notifications
+    ext.DebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    ext.DebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    return true;
+#endif
+}
+
+// identifier is GL_TEXTURE, GL_FRAMEBUFFER, GL_PROGRAM, GL_BUFFER, ...; the object has to exist,
+// i.e. been bound or created once, a name from glGen* alone is not enough
+inline void labelObject(GLenum identifier, GLuint name, const std::string &label) {
+    const GLExtensions &ext = glExtensions();
+    if (!ext.debug || name == 0)
+        return;
+    GLsizei length = (GLsizei) label.size();
+    if (length >= ext.maxLabelLength)
+        length = ext.maxLabelLength - 1;
+    ext.ObjectLabel(identifier, name, length, label.c_str());
+}
+
+// marks the commands issued during its lifetime as one named group
+class DebugGroup {
+public:
+    explicit DebugGroup(const char *name)
+            : m_active(glExtensions().debug) {
+        if (m_active)
+            glExtensions().PushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+    }
+
+    ~DebugGroup() {
+        if (m_active)
+            glExtensions().PopDebugGroup();
+    }
+
+    DebugGroup(const DebugGroup &) = delete;
+    DebugGroup &operator=(const DebugGroup &) = delete;
+
+private:
+    bool m_active;
+};
+
+};
+
+#endif //PROJECT_BASE_GLDEBUG_H
@@ -0,0 +1,183 @@
+//
+// Entry points newer than the GL 3.3 core profile glad was generated for.
+// They are loaded at runtime and are only used when the driver exposes them.
+//
+
+#ifndef PROJECT_BASE_GLEXTENSIONS_H
+#define PROJECT_BASE_GLEXTENSIONS_H
+
+#include <glad/glad.h>
+#include <cstring>
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_PROGRAM_BINARY_FORMATS
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+// KHR_debug
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_MAX_LABEL_LENGTH 0x82E8
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_BUFFER 0x82E0
+#define GL_SHADER 0x82E1
+#define GL_PROGRAM 0x82E2
+#define GL_QUERY 0x82E3
+#endif
+
+namespace rg {
+
+typedef void (APIENTRYP PFNRGMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect,
+                                                          GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNRGGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                  GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNRGPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary,
+                                               GLsizei length);
+typedef void (APIENTRYP PFNRGPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNRGMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+typedef void (APIENTRY *RGDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                     const GLchar *message, const void *userParam);
+typedef void (APIENTRYP PFNRGDEBUGMESSAGECALLBACKPROC)(RGDEBUGPROC callback, const void *userParam);
+typedef void (APIENTRYP PFNRGDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity, GLsizei count,
+                                                     const GLuint *ids, GLboolean enabled);
+typedef void (APIENTRYP PFNRGPUSHDEBUGGROUPPROC)(GLenum source, GLuint id, GLsizei length, const GLchar *message);
+typedef void (APIENTRYP PFNRGPOPDEBUGGROUPPROC)();
+typedef void (APIENTRYP PFNRGOBJECTLABELPROC)(GLenum identifier, GLuint name, GLsizei length, const GLchar *label);
+
+// layout of one command in GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+struct GLExtensions {
+    int majorVersion = 3;
+    int minorVersion = 3;
+
+    bool multiDrawIndirect = false;
+    PFNRGMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect = nullptr;
+
+    // GL 4.1 / ARB_get_program_binary, only set when the driver has at least one binary format
+    bool programBinary = false;
+    PFNRGGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+    PFNRGPROGRAMBINARYPROC ProgramBinary = nullptr;
+    PFNRGPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+
+    // KHR/ARB_parallel_shader_compile: compile and link return at once, GL_COMPLETION_STATUS_KHR
+    // tells when the result is ready
+    bool parallelShaderCompile = false;
+    PFNRGMAXSHADERCOMPILERTHREADSPROC MaxShaderCompilerThreads = nullptr;
+
+    // GL 4.3 / KHR_debug: messages through a callback, debug groups and object labels
+    bool debug = false;
+    GLint maxLabelLength = 0;
+    PFNRGDEBUGMESSAGECALLBACKPROC DebugMessageCallback = nullptr;
+    PFNRGDEBUGMESSAGECONTROLPROC DebugMessageControl = nullptr;
+    PFNRGPUSHDEBUGGROUPPROC PushDebugGroup = nullptr;
+    PFNRGPOPDEBUGGROUPPROC PopDebugGroup = nullptr;
+    PFNRGOBJECTLABELPROC ObjectLabel = nullptr;
+};
+
+inline GLExtensions &glExtensions() {
+    static GLExtensions extensions;
+    return extensions;
+}
+
+inline bool isVersionAtLeast(int major, int minor) {
+    const GLExtensions &ext = glExtensions();
+    return ext.majorVersion > major || (ext.majorVersion == major && ext.minorVersion >= minor);
+}
+
+inline bool hasExtension(const char *name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char *extension = (const char *) glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// must be called once after gladLoadGLLoader, with the same loader
+inline void loadGLExtensions(GLADloadproc load) {
+    GLExtensions &ext = glExtensions();
+    glGetIntegerv(GL_MAJOR_VERSION, &ext.majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &ext.minorVersion);
+
+    if (isVersionAtLeast(4, 3) || hasExtension("GL_ARB_multi_draw_indirect")) {
+        ext.MultiDrawElementsIndirect = (PFNRGMULTIDRAWELEMENTSINDIRECTPROC) load("glMultiDrawElementsIndirect");
+        ext.multiDrawIndirect = ext.MultiDrawElementsIndirect != nullptr;
+    }
+
+    if (isVersionAtLeast(4, 1) || hasExtension("GL_ARB_get_program_binary")) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        ext.GetProgramBinary = (PFNRGGETPROGRAMBINARYPROC) load("glGetProgramBinary");
+        ext.ProgramBinary = (PFNRGPROGRAMBINARYPROC) load("glProgramBinary");
+        ext.ProgramParameteri = (PFNRGPROGRAMPARAMETERIPROC) load("glProgramParameteri");
+        ext.programBinary = formats > 0 && ext.GetProgramBinary && ext.ProgramBinary && ext.ProgramParameteri;
+    }
+
+    if (hasExtension("GL_KHR_parallel_shader_compile"))
+        ext.MaxShaderCompilerThreads = (PFNRGMAXSHADERCOMPILERTHREADSPROC) load("glMaxShaderCompilerThreadsKHR");
+    else if (hasExtension("GL_ARB_parallel_shader_compile"))
+        ext.MaxShaderCompilerThreads = (PFNRGMAXSHADERCOMPILERTHREADSPROC) load("glMaxShaderCompilerThreadsARB");
+    if (ext.MaxShaderCompilerThreads) {
+        // let the driver pick as many threads as it wants
+        ext.MaxShaderCompilerThreads(0xFFFFFFFFu);
+        ext.parallelShaderCompile = true;
+    }
+
+    // desktop KHR_debug uses the unsuffixed names
+    if (isVersionAtLeast(4, 3) || hasExtension("GL_KHR_debug")) {
+        ext.DebugMessageCallback = (PFNRGDEBUGMESSAGECALLBACKPROC) load("glDebugMessageCallback");
+        ext.DebugMessageControl = (PFNRGDEBUGMESSAGECONTROLPROC) load("glDebugMessageControl");
+        ext.PushDebugGroup = (PFNRGPUSHDEBUGGROUPPROC) load("glPushDebugGroup");
+        ext.PopDebugGroup = (PFNRGPOPDEBUGGROUPPROC) load("glPopDebugGroup");
+        ext.ObjectLabel = (PFNRGOBJECTLABELPROC) load("glObjectLabel");
+        ext.debug = ext.DebugMessageCallback && ext.DebugMessageControl && ext.PushDebugGroup &&
+                    ext.PopDebugGroup && ext.ObjectLabel;
+        if (ext.debug)
+            glGetIntegerv(GL_MAX_LABEL_LENGTH, &ext.maxLabelLength);
+    }
+}
+
+};
+
+#endif //PROJECT_BASE_GLEXTENSIONS_H
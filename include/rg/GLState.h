@@ -0,0 +1,228 @@
+//
+// Shadow copy of the OpenGL state the renderer changes every frame.
+// Calls that would set a value which is already current are skipped.
+//
+
+#ifndef PROJECT_BASE_GLSTATE_H
+#define PROJECT_BASE_GLSTATE_H
+
+#include <glad/glad.h>
+
+namespace rg {
+
+class GLState {
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+
+    struct Counters {
+        unsigned int issued = 0;
+        unsigned int skipped = 0;
+        // issued binds by kind, part of issued
+        unsigned int programBinds = 0;
+        unsigned int vertexArrayBinds = 0;
+        unsigned int textureBinds = 0;
+    };
+
+    GLState() {
+        invalidate();
+    }
+
+    // forget everything, e.g. after code that does not go through the cache changed the state
+    void invalidate() {
+        m_program = UNKNOWN;
+        m_vertexArray = UNKNOWN;
+        m_activeTexture = UNKNOWN;
+        m_readFramebuffer = UNKNOWN;
+        m_drawFramebuffer = UNKNOWN;
+        for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+            for (unsigned int target = 0; target < TEXTURE_TARGETS; ++target)
+                m_textures[unit][target] = UNKNOWN;
+        for (unsigned int unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+            m_samplers[unit] = UNKNOWN;
+        for (unsigned int cap = 0; cap < CAPABILITIES; ++cap)
+            m_capabilities[cap] = UNKNOWN;
+        m_depthMask = UNKNOWN;
+        m_depthFunc = UNKNOWN;
+        m_frontFace = UNKNOWN;
+    }
+
+    // starts counting a new frame, the finished frame stays available through lastFrame()
+    void beginFrame() {
+        m_lastFrame = m_frame;
+        m_frame = Counters();
+    }
+
+    const Counters &lastFrame() const {
+        return m_lastFrame;
+    }
+
+    // counted so far in the frame being rendered
+    const Counters &currentFrame() const {
+        return m_frame;
+    }
+
+    void useProgram(GLuint program) {
+        if (changed(m_program, program)) {
+            ++m_frame.programBinds;
+            glUseProgram(program);
+        }
+    }
+
+    void bindVertexArray(GLuint vertexArray) {
+        if (changed(m_vertexArray, vertexArray)) {
+            ++m_frame.vertexArrayBinds;
+            glBindVertexArray(vertexArray);
+        }
+    }
+
+    void bindFramebuffer(GLenum target, GLuint framebuffer) {
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        if ((read && m_readFramebuffer != framebuffer) || (draw && m_drawFramebuffer != framebuffer)) {
+            if (read)
+                m_readFramebuffer = framebuffer;
+            if (draw)
+                m_drawFramebuffer = framebuffer;
+            ++m_frame.issued;
+            glBindFramebuffer(target, framebuffer);
+        } else {
+            ++m_frame.skipped;
+        }
+    }
+
+    void activeTexture(GLuint unit) {
+        if (changed(m_activeTexture, unit))
+            glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // binds texture to the given unit, switching the active unit only when the binding changes;
+    // with sampler 0 the texture's own filter and wrap parameters apply
+    void bindTexture(GLuint unit, GLenum target, GLuint texture, GLuint sampler = 0) {
+        // nearly every bind keeps sampler 0, that is not counted as a skipped call
+        if (unit >= MAX_TEXTURE_UNITS || m_samplers[unit] != sampler)
+            bindSampler(unit, sampler);
+        int slot = textureSlot(target);
+        if (slot < 0 || unit >= MAX_TEXTURE_UNITS) {
+            activeTexture(unit);
+            ++m_frame.issued;
+            ++m_frame.textureBinds;
+            glBindTexture(target, texture);
+            return;
+        }
+        if (m_textures[unit][slot] == texture) {
+            ++m_frame.skipped;
+            return;
+        }
+        activeTexture(unit);
+        m_textures[unit][slot] = texture;
+        ++m_frame.issued;
+        ++m_frame.textureBinds;
+        glBindTexture(target, texture);
+    }
+
+    // sampler objects override the sampling parameters of whatever texture is bound to the unit
+    void bindSampler(GLuint unit, GLuint sampler) {
+        if (unit >= MAX_TEXTURE_UNITS) {
+            ++m_frame.issued;
+            glBindSampler(unit, sampler);
+            return;
+        }
+        if (changed(m_samplers[unit], sampler))
+            glBindSampler(unit, sampler);
+    }
+
+    void setEnabled(GLenum capability, bool enabled) {
+        int slot = capabilitySlot(capability);
+        if (slot >= 0 && !changed(m_capabilities[slot], enabled ? 1u : 0u))
+            return;
+        if (slot < 0)
+            ++m_frame.issued;
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    void enable(GLenum capability) {
+        setEnabled(capability, true);
+    }
+
+    void disable(GLenum capability) {
+        setEnabled(capability, false);
+    }
+
+    void depthMask(GLboolean flag) {
+        if (changed(m_depthMask, flag))
+            glDepthMask(flag);
+    }
+
+    void depthFunc(GLenum func) {
+        if (changed(m_depthFunc, func))
+            glDepthFunc(func);
+    }
+
+    void frontFace(GLenum mode) {
+        if (changed(m_frontFace, mode))
+            glFrontFace(mode);
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const unsigned int TEXTURE_TARGETS = 4;
+    static const unsigned int CAPABILITIES = 3;
+
+    static int textureSlot(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_CUBE_MAP: return 1;
+            case GL_TEXTURE_BUFFER: return 2;
+            case GL_TEXTURE_2D_ARRAY: return 3;
+        }
+        return -1;
+    }
+
+    static int capabilitySlot(GLenum capability) {
+        switch (capability) {
+            case GL_DEPTH_TEST: return 0;
+            case GL_CULL_FACE: return 1;
+            case GL_BLEND: return 2;
+        }
+        return -1;
+    }
+
+    // records the new value and counts the call; returns false if the value was already current
+    bool changed(GLuint &current, GLuint value) {
+        if (current == value) {
+            ++m_frame.skipped;
+            return false;
+        }
+        current = value;
+        ++m_frame.issued;
+        return true;
+    }
+
+    GLuint m_program;
+    GLuint m_vertexArray;
+    GLuint m_activeTexture;
+    GLuint m_readFramebuffer;
+    GLuint m_drawFramebuffer;
+    GLuint m_textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    GLuint m_samplers[MAX_TEXTURE_UNITS];
+    GLuint m_capabilities[CAPABILITIES];
+    GLuint m_depthMask;
+    GLuint m_depthFunc;
+    GLuint m_frontFace;
+
+    Counters m_frame;
+    Counters m_lastFrame;
+};
+
+// all per-frame state changes go through this instance
+inline GLState &glState() {
+    static GLState state;
+    return state;
+}
+
+};
+
+#endif //PROJECT_BASE_GLSTATE_H
@@ -0,0 +1,207 @@
+//
+// GPU time of a span of commands, measured with GL_TIME_ELAPSED queries. Queries are kept in a
+// ring and read a few frames later, so measuring never makes the CPU wait for the GPU.
+//
+
+#ifndef PROJECT_BASE_GPUTIMER_H
+#define PROJECT_BASE_GPUTIMER_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace rg {
+
+struct GpuTimerSample {
+    // whatever was passed to begin(), e.g. the frame number
+    uint32_t tag;
+    double milliseconds;
+};
+
+class GpuTimer {
+public:
+    static const unsigned int QUERIES = 8;
+
+    GpuTimer() {
+        glGenQueries(QUERIES, m_queries);
+    }
+
+    ~GpuTimer() {
+        glDeleteQueries(QUERIES, m_queries);
+    }
+
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    // only one GL_TIME_ELAPSED query can be active, spans of different timers must not overlap
+    void begin(uint32_t tag = 0) {
+        // every query is still in flight; only happens when collect() is not called for a long time
+        if (m_pending == QUERIES)
+            read(true);
+        m_tags[m_next] = tag;
+        glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next]);
+    }
+
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_next = (m_next + 1) % QUERIES;
+        ++m_pending;
+    }
+
+    // calls onSample(const GpuTimerSample&) for every finished span, oldest first, without waiting
+    template<typename Callback>
+    void collect(Callback &&onSample) {
+        read(false);
+        for (const GpuTimerSample &sample : m_finished)
+            onSample(sample);
+        m_finished.clear();
+    }
+
+    // most recent finished span, 0 before the first one
+    double lastMilliseconds() const {
+        return m_lastMilliseconds;
+    }
+
+private:
+    void read(bool waitForOldest) {
+        while (m_pending > 0) {
+            unsigned int oldest = (m_next + QUERIES - m_pending) % QUERIES;
+            if (!waitForOldest) {
+                GLint available = GL_FALSE;
+                glGetQueryObjectiv(m_queries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    return;
+            }
+            waitForOldest = false;
+
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(m_queries[oldest], GL_QUERY_RESULT, &nanoseconds);
+            m_lastMilliseconds = nanoseconds / 1.0e6;
+            m_finished.push_back(GpuTimerSample{m_tags[oldest], m_lastMilliseconds});
+            --m_pending;
+        }
+    }
+
+    GLuint m_queries[QUERIES];
+    uint32_t m_tags[QUERIES];
+    unsigned int m_next = 0;
+    unsigned int m_pending = 0;
+    std::vector<GpuTimerSample> m_finished;
+    double m_lastMilliseconds = 0.0;
+};
+
+struct GpuPassSample {
+    // string literal, only the pointer is kept
+    const char *name;
+    double milliseconds;
+};
+
+// GPU time of every pass of a frame, from GL_TIMESTAMP queries at the pass boundaries. Unlike
+// GL_TIME_ELAPSED these may be issued while a GpuTimer span is open. Frames are kept in a ring
+// and read back a few frames later, like GpuTimer.
+class GpuPassTimer {
+public:
+    static const unsigned int FRAMES = 4;
+    static const unsigned int MAX_PASSES = 31;
+
+    GpuPassTimer() {
+        for (Frame &frame : m_frames)
+            glGenQueries(MAX_PASSES + 1, frame.queries);
+    }
+
+    ~GpuPassTimer() {
+        for (Frame &frame : m_frames)
+            glDeleteQueries(MAX_PASSES + 1, frame.queries);
+    }
+
+    GpuPassTimer(const GpuPassTimer &) = delete;
+    GpuPassTimer &operator=(const GpuPassTimer &) = delete;
+
+    void beginFrame(uint32_t tag) {
+        // every frame is in flight or waits for collect(); only happens when collect() is not
+        // called for a long time, the oldest frame is dropped
+        if (m_pending + m_finished == FRAMES) {
+            if (m_finished == 0)
+                read(true);
+            --m_finished;
+        }
+        Frame &frame = m_frames[m_next];
+        frame.tag = tag;
+        frame.passes = 0;
+    }
+
+    // the pass starts here and runs until the next mark() or endFrame(); passes over MAX_PASSES
+    // are merged into the last one
+    void mark(const char *name) {
+        Frame &frame = m_frames[m_next];
+        if (frame.passes == MAX_PASSES)
+            return;
+        frame.names[frame.passes] = name;
+        glQueryCounter(frame.queries[frame.passes++], GL_TIMESTAMP);
+    }
+
+    void endFrame() {
+        Frame &frame = m_frames[m_next];
+        glQueryCounter(frame.queries[frame.passes], GL_TIMESTAMP);
+        m_next = (m_next + 1) % FRAMES;
+        ++m_pending;
+    }
+
+    // calls onFrame(uint32_t tag, const GpuPassSample *passes, unsigned int count) for every
+    // finished frame, oldest first, without waiting
+    template<typename Callback>
+    void collect(Callback &&onFrame) {
+        read(false);
+        for (; m_finished > 0; --m_finished) {
+            const Frame &frame = m_frames[(m_next + FRAMES - m_pending - m_finished) % FRAMES];
+            onFrame(frame.tag, frame.samples, frame.passes);
+        }
+    }
+
+private:
+    struct Frame {
+        GLuint queries[MAX_PASSES + 1];
+        const char *names[MAX_PASSES];
+        // filled in once the frame has finished
+        GpuPassSample samples[MAX_PASSES];
+        unsigned int passes = 0;
+        uint32_t tag = 0;
+    };
+
+    // the ring holds, oldest first, m_finished frames that wait for collect() and m_pending
+    // frames in flight, then m_next
+    void read(bool waitForOldest) {
+        while (m_pending > 0) {
+            Frame &frame = m_frames[(m_next + FRAMES - m_pending) % FRAMES];
+            // the last timestamp finishes after all the others
+            if (!waitForOldest) {
+                GLint available = GL_FALSE;
+                glGetQueryObjectiv(frame.queries[frame.passes], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    return;
+            }
+            waitForOldest = false;
+
+            GLuint64 previous = 0;
+            glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &previous);
+            for (unsigned int pass = 0; pass < frame.passes; ++pass) {
+                GLuint64 next = 0;
+                glGetQueryObjectui64v(frame.queries[pass + 1], GL_QUERY_RESULT, &next);
+                frame.samples[pass] = GpuPassSample{frame.names[pass], (next - previous) / 1.0e6};
+                previous = next;
+            }
+            --m_pending;
+            ++m_finished;
+        }
+    }
+
+    Frame m_frames[FRAMES];
+    unsigned int m_next = 0;
+    unsigned int m_pending = 0;
+    unsigned int m_finished = 0;
+};
+
+};
+
+#endif //PROJECT_BASE_GPUTIMER_H
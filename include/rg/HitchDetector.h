@@ -0,0 +1,201 @@
+//
+// Hitch detector: compares the CPU time of every frame with the median of the recent frames. A
+// frame over budget gets a report with its profiler zones, counters and game state. The GPU
+// pass times of the same frame arrive a few frames later and are added before the report is
+// written. Reports go to a log that rotates at a size limit, so it can stay on for players.
+//
+
+#ifndef PROJECT_BASE_HITCHDETECTOR_H
+#define PROJECT_BASE_HITCHDETECTOR_H
+
+#include <rg/FrameStats.h>
+#include <rg/GpuTimer.h>
+#include <rg/Profiler.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+struct HitchSettings {
+    bool enabled = true;
+    // a frame is a hitch above this multiple of the median frame time...
+    float medianFactor = 2.0f;
+    // ...and above this many milliseconds, so a fast median does not turn noise into hitches
+    float minMilliseconds = 8.0f;
+};
+
+class HitchDetector {
+public:
+    // frames in the rolling median, and how many have to be there before anything counts
+    static const unsigned int WINDOW = 120;
+    static const unsigned int MIN_FRAMES = 30;
+    // a report waits this many frames for its GPU times, then is written without them
+    static const uint32_t GPU_WAIT_FRAMES = 8;
+
+    // the log is path, older ones path.1 ... path.(logFiles - 1)
+    explicit HitchDetector(const std::string &path, size_t maxLogBytes = 256 * 1024, unsigned int logFiles = 3)
+            : m_path(path), m_maxLogBytes(maxLogBytes), m_logFiles(std::max(logFiles, 1u)) {
+        m_window.reserve(WINDOW);
+        m_sorted.reserve(WINDOW);
+    }
+
+    ~HitchDetector() {
+        for (const Pending &pending : m_pending)
+            write(pending.text + "  gpu passes: not measured\n\n");
+    }
+
+    HitchDetector(const HitchDetector &) = delete;
+    HitchDetector &operator=(const HitchDetector &) = delete;
+
+    // closes a frame; true when it is a hitch, report() should follow
+    bool addFrame(const HitchSettings &settings, double milliseconds) {
+        bool hitch = false;
+        if (settings.enabled && m_window.size() >= MIN_FRAMES) {
+            m_sorted = m_window;
+            std::nth_element(m_sorted.begin(), m_sorted.begin() + m_sorted.size() / 2, m_sorted.end());
+            m_median = m_sorted[m_sorted.size() / 2];
+            hitch = milliseconds > std::max(m_median * settings.medianFactor, (double) settings.minMilliseconds);
+        }
+        if (m_window.size() < WINDOW)
+            m_window.push_back(milliseconds);
+        else
+            m_window[m_next] = milliseconds;
+        m_next = (m_next + 1) % WINDOW;
+        if (hitch)
+            ++m_hitches;
+        return hitch;
+    }
+
+    // state holds name/value pairs of the game, e.g. the score
+    void report(uint32_t frame, double milliseconds, const std::vector<ProfileZoneSample> &zones,
+                const FrameStats &stats, const std::vector<std::pair<const char *, double>> &state) {
+        char line[256];
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+        std::snprintf(line, sizeof(line), "Hitch at %s, frame %u: %.2f ms, median %.2f ms\n", date, frame,
+                      milliseconds, m_median);
+        std::string text = line;
+
+        text += "  cpu zones:\n";
+        for (const ProfileZoneSample &zone : zones) {
+            std::snprintf(line, sizeof(line), "    %*s%-24s %8.3f ms  (at %.3f ms)", zone.depth * 2, "",
+                          zone.name, zone.milliseconds, zone.startMilliseconds);
+            text += line;
+            if (RG_ALLOCATION_TRACKING) {
+                std::snprintf(line, sizeof(line), "  %llu allocations", (unsigned long long) zone.allocations);
+                text += line;
+            }
+            text += '\n';
+        }
+        std::snprintf(line, sizeof(line),
+                      "  counters: %u draws, %llu triangles, %u program / %u VAO / %u texture binds, "
+                      "%u uniforms, %llu upload bytes, %u culled\n",
+                      stats.drawCalls, (unsigned long long) stats.triangles, stats.programBinds,
+                      stats.vertexArrayBinds, stats.textureBinds, stats.uniformUploads,
+                      (unsigned long long) stats.bufferUploadBytes, stats.culledObjects);
+        text += line;
+        text += "  game:";
+        for (const std::pair<const char *, double> &value : state) {
+            std::snprintf(line, sizeof(line), " %s %g", value.first, value.second);
+            text += line;
+        }
+        text += '\n';
+        m_pending.push_back(Pending{frame, std::move(text)});
+    }
+
+    // GPU pass times tagged with the frame they belong to, from GpuPassTimer::collect()
+    void addGpuPasses(uint32_t frame, const GpuPassSample *passes, unsigned int count) {
+        for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->frame != frame)
+                continue;
+            std::string text = std::move(it->text);
+            text += "  gpu passes:\n";
+            char line[128];
+            for (unsigned int pass = 0; pass < count; ++pass) {
+                std::snprintf(line, sizeof(line), "    %-24s %8.3f ms\n", passes[pass].name, passes[pass].milliseconds);
+                text += line;
+            }
+            m_pending.erase(it);
+            write(text + '\n');
+            return;
+        }
+    }
+
+    // writes the reports whose GPU times did not arrive in time; once per frame
+    void update(uint32_t frame) {
+        while (!m_pending.empty() && frame - m_pending.front().frame > GPU_WAIT_FRAMES) {
+            write(m_pending.front().text + "  gpu passes: not measured\n\n");
+            m_pending.pop_front();
+        }
+    }
+
+    unsigned int hitchCount() const {
+        return m_hitches;
+    }
+
+    double medianMilliseconds() const {
+        return m_median;
+    }
+
+    const std::string &path() const {
+        return m_path;
+    }
+
+private:
+    struct Pending {
+        uint32_t frame;
+        std::string text;
+    };
+
+    // one flush per report; reports are rare and only written frames after the hitch itself
+    void write(const std::string &text) {
+        if (!m_log.is_open()) {
+            m_log.open(m_path, std::ios::app);
+            m_log.seekp(0, std::ios::end);
+            m_logBytes = (size_t) std::max((std::streamoff) m_log.tellp(), (std::streamoff) 0);
+        }
+        if (m_logBytes > 0 && m_logBytes + text.size() > m_maxLogBytes)
+            rotate();
+        m_log << text;
+        m_log.flush();
+        m_logBytes += text.size();
+    }
+
+    void rotate() {
+        m_log.close();
+        for (unsigned int i = m_logFiles - 1; i > 0; --i) {
+            std::string older = m_path + "." + std::to_string(i);
+            std::string newer = i == 1 ? m_path : m_path + "." + std::to_string(i - 1);
+            std::remove(older.c_str());
+            std::rename(newer.c_str(), older.c_str());
+        }
+        m_log.open(m_path, std::ios::trunc);
+        m_logBytes = 0;
+    }
+
+    std::string m_path;
+    size_t m_maxLogBytes;
+    unsigned int m_logFiles;
+    std::ofstream m_log;
+    size_t m_logBytes = 0;
+
+    std::vector<double> m_window;
+    std::vector<double> m_sorted;
+    size_t m_next = 0;
+    double m_median = 0.0;
+    unsigned int m_hitches = 0;
+    std::deque<Pending> m_pending;
+};
+
+};
+
+#endif //PROJECT_BASE_HITCHDETECTOR_H
@@ -0,0 +1,269 @@
+//
+// Clustered forward lighting. The view frustum is split into a grid of froxels (screen tiles
+// times exponential depth slices); every frame the CPU assigns each point light to the froxels
+// its radius reaches and uploads the result into texture buffers. Fragment shaders look up their
+// froxel and shade only the lights listed there (see resources/shaders/lighting.glsl).
+//
+
+#ifndef PROJECT_BASE_LIGHTCLUSTERS_H
+#define PROJECT_BASE_LIGHTCLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/shader.h>
+#include <rg/FrameArena.h>
+#include <rg/FrameStats.h>
+#include <rg/GLState.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// grid resolution, also passed to the shaders as defines (see LightClusters::shaderDefines)
+const int CLUSTER_TILES_X = 16;
+const int CLUSTER_TILES_Y = 9;
+const int CLUSTER_SLICES = 24;
+const int CLUSTER_COUNT = CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES;
+
+// texture units of the light data, index list and per-cluster ranges; above the material units
+const unsigned int CLUSTER_TEXTURE_UNIT = 16;
+
+// GPU layout of one point light, four RGBA32F texels
+struct ClusterLight {
+    glm::vec4 positionRadius;
+    glm::vec4 diffuseConstant;
+    glm::vec4 ambientLinear;
+    glm::vec4 specularQuadratic;
+};
+
+// distance at which the attenuated light drops below 5/256 of its brightest channel
+inline float lightRadius(float constant, float linear, float quadratic, float maxComponent) {
+    float threshold = maxComponent * 256.0f / 5.0f;
+    if (quadratic <= 0.0f)
+        return linear > 0.0f ? std::max(threshold - constant, 0.0f) / linear : 1e6f;
+    float discriminant = linear * linear - 4.0f * quadratic * (constant - threshold);
+    return discriminant > 0.0f ? (-linear + std::sqrt(discriminant)) / (2.0f * quadratic) : 0.0f;
+}
+
+inline ClusterLight makeClusterLight(const glm::vec3 &position, const glm::vec3 &ambient, const glm::vec3 &diffuse,
+                                     const glm::vec3 &specular, float constant, float linear, float quadratic) {
+    float maxComponent = std::max(std::max(diffuse.x, diffuse.y), diffuse.z);
+    maxComponent = std::max(maxComponent, std::max(std::max(specular.x, specular.y), specular.z));
+    maxComponent = std::max(maxComponent, std::max(std::max(ambient.x, ambient.y), ambient.z));
+    ClusterLight light;
+    light.positionRadius = glm::vec4(position, lightRadius(constant, linear, quadratic, maxComponent));
+    light.diffuseConstant = glm::vec4(diffuse, constant);
+    light.ambientLinear = glm::vec4(ambient, linear);
+    light.specularQuadratic = glm::vec4(specular, quadratic);
+    return light;
+}
+
+class LightClusters {
+public:
+    LightClusters() {
+        glGenBuffers(BUFFERS, m_buffers);
+        glGenTextures(BUFFERS, m_textures);
+        const GLenum formats[BUFFERS] = {GL_RGBA32F, GL_R16UI, GL_RG32UI};
+        for (int i = 0; i < BUFFERS; ++i) {
+            glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        m_ranges.resize(CLUSTER_COUNT);
+        m_counts.resize(CLUSTER_COUNT);
+    }
+
+    ~LightClusters() {
+        glDeleteTextures(BUFFERS, m_textures);
+        glDeleteBuffers(BUFFERS, m_buffers);
+    }
+
+    LightClusters(const LightClusters &) = delete;
+    LightClusters &operator=(const LightClusters &) = delete;
+
+    // defines every program that includes lighting.glsl has to be built with
+    static std::vector<std::string> shaderDefines() {
+        return {
+                "CLUSTER_TILES_X " + std::to_string(CLUSTER_TILES_X),
+                "CLUSTER_TILES_Y " + std::to_string(CLUSTER_TILES_Y),
+                "CLUSTER_SLICES " + std::to_string(CLUSTER_SLICES)
+        };
+    }
+
+    // points the cluster samplers at their units, once per program; the program has to be in use
+    static void configureSamplers(const Shader &shader) {
+        shader.setInt("clusterLights", CLUSTER_TEXTURE_UNIT);
+        shader.setInt("clusterLightIndices", CLUSTER_TEXTURE_UNIT + 1);
+        shader.setInt("clusterRanges", CLUSTER_TEXTURE_UNIT + 2);
+    }
+
+    void clear() {
+        m_lights.clear();
+    }
+
+    void addLight(const ClusterLight &light) {
+        m_lights.push_back(light);
+    }
+
+    // assigns the lights to froxels for this view and uploads everything; viewportSize is the size
+    // of the viewport the lit passes render with
+    void build(const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane,
+               const glm::vec2 &viewportSize) {
+        m_viewportSize = viewportSize;
+        m_nearPlane = nearPlane;
+        m_farPlane = farPlane;
+        float logDepthRange = std::log(farPlane / nearPlane);
+        m_sliceScale = CLUSTER_SLICES / logDepthRange;
+        m_sliceBias = -CLUSTER_SLICES * std::log(nearPlane) / logDepthRange;
+
+        // 1. every (cluster, light) pair the light touches, in the frame arena; last frame's count
+        // is a good guess, so the list rarely grows
+        FrameVector<Pair> pairs;
+        pairs.reserve(m_indices.size());
+        std::fill(m_counts.begin(), m_counts.end(), 0u);
+        for (size_t i = 0; i < m_lights.size() && i <= 0xFFFF; ++i) {
+            glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(m_lights[i].positionRadius), 1.0f));
+            assignLight(pairs, (uint32_t) i, center, m_lights[i].positionRadius.w, projection);
+        }
+
+        // 2. counting sort of the pairs by cluster: ranges are prefix sums of the counts
+        uint32_t offset = 0;
+        for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+            m_ranges[cluster] = glm::uvec2(offset, 0u);
+            offset += m_counts[cluster];
+        }
+        m_indices.resize(pairs.size());
+        for (const Pair &pair : pairs) {
+            glm::uvec2 &range = m_ranges[pair.cluster];
+            m_indices[range.x + range.y++] = (uint16_t) pair.light;
+        }
+
+        upload(0, m_lights.data(), m_lights.size() * sizeof(ClusterLight));
+        upload(1, m_indices.data(), m_indices.size() * sizeof(uint16_t));
+        upload(2, m_ranges.data(), m_ranges.size() * sizeof(glm::uvec2));
+    }
+
+    void bind() const {
+        for (int i = 0; i < BUFFERS; ++i)
+            glState().bindTexture(CLUSTER_TEXTURE_UNIT + i, GL_TEXTURE_BUFFER, m_textures[i]);
+    }
+
+    // per-frame uniforms of the grid built last
+    void setUniforms(const Shader &shader) const {
+        shader.setVec2("clusterTileSize", m_viewportSize / glm::vec2(CLUSTER_TILES_X, CLUSTER_TILES_Y));
+        shader.setVec2("clusterDepthParams", m_sliceScale, m_sliceBias);
+        shader.setVec2("clusterPlanes", m_nearPlane, m_farPlane);
+    }
+
+    size_t lightCount() const {
+        return m_lights.size();
+    }
+
+    // total entries of all per-cluster light lists
+    size_t indexCount() const {
+        return m_indices.size();
+    }
+
+private:
+    static const int BUFFERS = 3;
+
+    struct Pair {
+        uint32_t cluster;
+        uint32_t light;
+    };
+
+    // view-space depth of the near edge of a slice
+    float sliceDepth(int slice) const {
+        return m_nearPlane * std::pow(m_farPlane / m_nearPlane, (float) slice / CLUSTER_SLICES);
+    }
+
+    void assignLight(FrameVector<Pair> &pairs, uint32_t light, const glm::vec3 &center, float radius,
+                     const glm::mat4 &projection) {
+        // view space looks down -z
+        float depth = -center.z;
+        if (depth + radius < m_nearPlane || depth - radius > m_farPlane)
+            return;
+
+        int firstSlice = depthToSlice(std::max(depth - radius, m_nearPlane));
+        int lastSlice = depthToSlice(std::min(depth + radius, m_farPlane));
+        for (int slice = firstSlice; slice <= lastSlice; ++slice) {
+            // part of the sphere's bounding box inside this slice
+            float sliceNear = std::max(sliceDepth(slice), depth - radius);
+            float sliceFar = std::min(sliceDepth(slice + 1), depth + radius);
+
+            // project the box corners at both depths, x and y extents are conservative
+            float minX = 1.0f, maxX = -1.0f, minY = 1.0f, maxY = -1.0f;
+            const float depths[2] = {sliceNear, sliceFar};
+            for (float d : depths) {
+                for (int corner = 0; corner < 4; ++corner) {
+                    float x = center.x + ((corner & 1) ? radius : -radius);
+                    float y = center.y + ((corner & 2) ? radius : -radius);
+                    float ndcX = projection[0][0] * x / d;
+                    float ndcY = projection[1][1] * y / d;
+                    minX = std::min(minX, ndcX);
+                    maxX = std::max(maxX, ndcX);
+                    minY = std::min(minY, ndcY);
+                    maxY = std::max(maxY, ndcY);
+                }
+            }
+            if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+                continue;
+
+            int firstX = ndcToTile(minX, CLUSTER_TILES_X), lastX = ndcToTile(maxX, CLUSTER_TILES_X);
+            int firstY = ndcToTile(minY, CLUSTER_TILES_Y), lastY = ndcToTile(maxY, CLUSTER_TILES_Y);
+            for (int y = firstY; y <= lastY; ++y) {
+                for (int x = firstX; x <= lastX; ++x) {
+                    uint32_t cluster = (uint32_t) ((slice * CLUSTER_TILES_Y + y) * CLUSTER_TILES_X + x);
+                    pairs.push_back(Pair{cluster, light});
+                    ++m_counts[cluster];
+                }
+            }
+        }
+    }
+
+    // same mapping as clusterIndex() in lighting.glsl
+    int depthToSlice(float depth) const {
+        int slice = (int) std::floor(std::log(depth) * m_sliceScale + m_sliceBias);
+        return std::min(std::max(slice, 0), CLUSTER_SLICES - 1);
+    }
+
+    static int ndcToTile(float ndc, int tiles) {
+        int tile = (int) std::floor((ndc * 0.5f + 0.5f) * tiles);
+        return std::min(std::max(tile, 0), tiles - 1);
+    }
+
+    // orphans the old storage so the upload does not wait for draws still reading it
+    void upload(int buffer, const void *data, size_t size) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[buffer]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max(size, (size_t) 16), nullptr, GL_STREAM_DRAW);
+        if (size > 0)
+            bufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    GLuint m_buffers[BUFFERS];
+    GLuint m_textures[BUFFERS];
+
+    std::vector<ClusterLight> m_lights;
+    std::vector<uint32_t> m_counts;
+    std::vector<uint16_t> m_indices;
+    std::vector<glm::uvec2> m_ranges;
+
+    glm::vec2 m_viewportSize = glm::vec2(1.0f);
+    float m_nearPlane = 0.1f;
+    float m_farPlane = 100.0f;
+    float m_sliceScale = 0.0f;
+    float m_sliceBias = 0.0f;
+};
+
+};
+
+#endif //PROJECT_BASE_LIGHTCLUSTERS_H
@@ -0,0 +1,108 @@
+//
+// CPU profiler zones: named, nested spans of the frame measured with a steady clock. A frame's
+// zones stay available until the next frame ends, e.g. to explain a slow frame after the fact.
+//
+
+#ifndef PROJECT_BASE_PROFILER_H
+#define PROJECT_BASE_PROFILER_H
+
+#include <rg/AllocationTracker.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace rg {
+
+struct ProfileZoneSample {
+    // string literal, zones only keep the pointer
+    const char *name;
+    // 0 for zones that are not inside another zone
+    int depth;
+    // from the start of the frame
+    double startMilliseconds;
+    double milliseconds;
+    // heap allocations of the recording thread inside the zone, nested zones included; always 0
+    // without RG_ALLOCATION_TRACKING
+    uint64_t allocations;
+};
+
+class CpuProfiler {
+public:
+    CpuProfiler() {
+        m_zones.reserve(128);
+        m_lastFrame.reserve(128);
+        m_frameStart = Clock::now();
+    }
+
+    // the zones recorded so far move to lastFrame()
+    void beginFrame() {
+        m_lastFrame.swap(m_zones);
+        m_zones.clear();
+        m_depth = 0;
+        m_frameStart = Clock::now();
+    }
+
+    // returns the handle end() takes; zones have to end in the reverse order they began
+    int begin(const char *name) {
+        // allocations holds the count at the start until end()
+        m_zones.push_back(ProfileZoneSample{name, m_depth++, elapsed(), 0.0, threadAllocations().allocations});
+        return (int) m_zones.size() - 1;
+    }
+
+    void end(int zone) {
+        ProfileZoneSample &sample = m_zones[zone];
+        sample.milliseconds = elapsed() - sample.startMilliseconds;
+        sample.allocations = threadAllocations().allocations - sample.allocations;
+        --m_depth;
+    }
+
+    // zones of the frame being recorded, in the order they began
+    const std::vector<ProfileZoneSample> &zones() const {
+        return m_zones;
+    }
+
+    const std::vector<ProfileZoneSample> &lastFrame() const {
+        return m_lastFrame;
+    }
+
+    // since beginFrame()
+    double elapsed() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - m_frameStart).count();
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<ProfileZoneSample> m_zones;
+    std::vector<ProfileZoneSample> m_lastFrame;
+    Clock::time_point m_frameStart;
+    int m_depth = 0;
+};
+
+inline CpuProfiler &cpuProfiler() {
+    static CpuProfiler profiler;
+    return profiler;
+}
+
+// one zone for the lifetime of the object
+class ProfileZone {
+public:
+    explicit ProfileZone(const char *name)
+            : m_zone(cpuProfiler().begin(name)) {
+    }
+
+    ~ProfileZone() {
+        cpuProfiler().end(m_zone);
+    }
+
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    int m_zone;
+};
+
+};
+
+#endif //PROJECT_BASE_PROFILER_H
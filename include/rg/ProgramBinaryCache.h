@@ -0,0 +1,175 @@
+//
+// Linked programs saved to disk with glGetProgramBinary and loaded back with glProgramBinary.
+// Binaries are keyed by the driver strings and the final (specialized) shader sources, so a
+// driver update or any change to a shader or its defines simply misses the cache.
+//
+
+#ifndef PROJECT_BASE_PROGRAMBINARYCACHE_H
+#define PROJECT_BASE_PROGRAMBINARYCACHE_H
+
+#include <glad/glad.h>
+#include <rg/GLExtensions.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// FNV-1a, continues from a previous hash when one is given
+inline uint64_t hashString(const std::string &data, uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+class ProgramBinaryCache {
+public:
+    explicit ProgramBinaryCache(const std::string &directory)
+            : m_directory(directory) {
+        mkdir(m_directory.c_str(), 0755);
+
+        const char *vendor = (const char *) glGetString(GL_VENDOR);
+        const char *renderer = (const char *) glGetString(GL_RENDERER);
+        const char *version = (const char *) glGetString(GL_VERSION);
+        std::string driver = std::string(vendor ? vendor : "") + '|' + (renderer ? renderer : "") + '|' +
+                             (version ? version : "");
+        m_driverHash = hashString(driver);
+
+        if (enabled()) {
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            m_formats.resize(formats);
+            glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, m_formats.data());
+        }
+    }
+
+    bool enabled() const {
+        return glExtensions().programBinary;
+    }
+
+    // the sources are the ones handed to the compiler, defines already inserted
+    uint64_t key(const std::string &vertexCode, const std::string &fragmentCode) const {
+        uint64_t hash = hashString(vertexCode, m_driverHash);
+        hash = hashString("|", hash);
+        return hashString(fragmentCode, hash);
+    }
+
+    // returns a linked program or 0 when there is no usable binary for the key
+    GLuint load(uint64_t key) {
+        if (!enabled())
+            return 0;
+        std::ifstream in(path(key), std::ios::binary);
+        if (!in) {
+            ++m_misses;
+            return 0;
+        }
+
+        Header header;
+        in.read((char *) &header, sizeof(header));
+        // a format the driver does not list would make glProgramBinary raise GL_INVALID_ENUM, which
+        // the debug callback reports as an error (and traps on with RG_GL_CHECKS=SYNC)
+        if (!in || header.magic != MAGIC || header.key != key || header.length == 0 ||
+            header.length > MAX_BINARY_SIZE ||
+            std::find(m_formats.begin(), m_formats.end(), (GLint) header.format) == m_formats.end()) {
+            ++m_misses;
+            return 0;
+        }
+        std::vector<char> binary(header.length);
+        in.read(binary.data(), binary.size());
+        if (!in) {
+            ++m_misses;
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glExtensions().ProgramBinary(program, header.format, binary.data(), (GLsizei) binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            // the driver rejected the binary, the caller compiles from source and replaces the file
+            glDeleteProgram(program);
+            ++m_misses;
+            return 0;
+        }
+        ++m_hits;
+        return program;
+    }
+
+    void store(uint64_t key, GLuint program) {
+        if (!enabled())
+            return;
+        GLint linked = GL_FALSE;
+        GLint length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!linked || length <= 0)
+            return;
+
+        std::vector<char> binary(length);
+        Header header;
+        header.magic = MAGIC;
+        header.key = key;
+        GLsizei written = 0;
+        glExtensions().GetProgramBinary(program, length, &written, &header.format, binary.data());
+        if (written <= 0)
+            return;
+        header.length = (uint32_t) written;
+
+        // written next to the final file and renamed, so a crash never leaves a half-written binary
+        std::string file = path(key);
+        std::string temporary = file + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write((const char *) &header, sizeof(header));
+            out.write(binary.data(), written);
+            if (!out)
+                return;
+        }
+        std::rename(temporary.c_str(), file.c_str());
+    }
+
+    unsigned int hits() const {
+        return m_hits;
+    }
+
+    unsigned int misses() const {
+        return m_misses;
+    }
+
+private:
+    static const uint32_t MAGIC = 0x42504752; // "RGPB"
+    static const uint32_t MAX_BINARY_SIZE = 64u << 20;
+
+    struct Header {
+        uint32_t magic = 0;
+        GLenum format = 0;
+        uint64_t key = 0;
+        uint32_t length = 0;
+    };
+
+    std::string path(uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key);
+        return m_directory + '/' + name;
+    }
+
+    std::string m_directory;
+    uint64_t m_driverHash;
+    // binary formats the driver accepts
+    std::vector<GLint> m_formats;
+    unsigned int m_hits = 0;
+    unsigned int m_misses = 0;
+};
+
+};
+
+#endif //PROJECT_BASE_PROGRAMBINARYCACHE_H
@@ -0,0 +1,514 @@
+//
+// Frame graph: every frame the passes are declared in execution order together with the
+// textures they read and write. compile() culls passes whose results nothing consumes and
+// assigns the transient textures to pooled GL textures; transients of the same format whose
+// lifetimes do not overlap share one texture. Passes that write the window (the backbuffer) or
+// an output are the roots. The filter of a transient is a sampler object bound together with the
+// texture, so aliases with different filters can share it.
+//
+
+#ifndef PROJECT_BASE_RENDERGRAPH_H
+#define PROJECT_BASE_RENDERGRAPH_H
+
+#include <glad/glad.h>
+
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+#include <rg/GpuTimer.h>
+#include <rg/Profiler.h>
+#include <rg/RenderTarget.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+typedef int GraphResource;
+const GraphResource GRAPH_NONE = -1;
+
+// transient textures have the size passed to RenderGraph::beginFrame, divided by downsample
+// and rounded up
+struct GraphTextureDesc {
+    GLenum internalFormat;
+    GLenum filter;
+    int downsample = 1;
+};
+
+class RenderGraph;
+
+// void() callable kept inside the pass. std::function would put every lambda that captures more
+// than two references on the heap, i.e. every pass of every frame.
+class PassFunction {
+public:
+    static const size_t CAPACITY = 256;
+
+    template<typename Function>
+    explicit PassFunction(Function &&function) {
+        typedef typename std::decay<Function>::type Stored;
+        static_assert(sizeof(Stored) <= CAPACITY, "the pass captures too much, raise PassFunction::CAPACITY");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "the pass needs a stricter alignment");
+        new (&m_storage) Stored(std::forward<Function>(function));
+        m_invoke = [](const void *stored) {
+            (*static_cast<const Stored *>(stored))();
+        };
+        // moves into destination unless it is null, then destroys source
+        m_relocate = [](void *destination, void *source) {
+            if (destination)
+                new (destination) Stored(std::move(*static_cast<Stored *>(source)));
+            static_cast<Stored *>(source)->~Stored();
+        };
+    }
+
+    PassFunction(PassFunction &&other) noexcept
+            : m_invoke(other.m_invoke), m_relocate(other.m_relocate) {
+        m_relocate(&m_storage, &other.m_storage);
+        other.m_relocate = nullptr;
+    }
+
+    ~PassFunction() {
+        if (m_relocate)
+            m_relocate(nullptr, &m_storage);
+    }
+
+    PassFunction(const PassFunction &) = delete;
+    PassFunction &operator=(const PassFunction &) = delete;
+    PassFunction &operator=(PassFunction &&) = delete;
+
+    void operator()() const {
+        m_invoke(&m_storage);
+    }
+
+private:
+    typename std::aligned_storage<CAPACITY, alignof(std::max_align_t)>::type m_storage;
+    void (*m_invoke)(const void *);
+    void (*m_relocate)(void *, void *);
+};
+
+class PassBuilder {
+public:
+    void read(GraphResource resource) {
+        if (resource != GRAPH_NONE)
+            m_reads->push_back(resource);
+    }
+
+    void write(GraphResource resource) {
+        if (resource != GRAPH_NONE)
+            m_writes->push_back(resource);
+    }
+
+private:
+    friend class RenderGraph;
+
+    PassBuilder(std::vector<GraphResource> *reads, std::vector<GraphResource> *writes)
+            : m_reads(reads), m_writes(writes) {
+    }
+
+    std::vector<GraphResource> *m_reads;
+    std::vector<GraphResource> *m_writes;
+};
+
+class RenderGraph {
+public:
+    RenderGraph() = default;
+
+    ~RenderGraph() {
+        releaseAll();
+        for (const std::pair<GLenum, GLuint> &sampler : m_samplers)
+            glDeleteSamplers(1, &sampler.second);
+    }
+
+    RenderGraph(const RenderGraph &) = delete;
+    RenderGraph &operator=(const RenderGraph &) = delete;
+
+    static int downsampled(int size, int downsample) {
+        return (size + downsample - 1) / downsample;
+    }
+
+    // forgets the previous frame's passes; a new size drops every pooled texture
+    void beginFrame(int width, int height) {
+        if (width != m_width || height != m_height) {
+            releaseAll();
+            m_width = width;
+            m_height = height;
+        }
+        m_passes.clear();
+        m_reads.clear();
+        m_writes.clear();
+        m_resources.clear();
+        ++m_frame;
+    }
+
+    // a texture that lives outside the graph, e.g. a history that has to survive the frame
+    GraphResource importTexture(const char *name, GLuint texture) {
+        m_resources.push_back(Resource{name, IMPORTED, {GL_NONE, GL_NONE, 1}, texture});
+        return (GraphResource) m_resources.size() - 1;
+    }
+
+    // the default framebuffer; passes that write it are never culled
+    GraphResource importBackbuffer() {
+        m_resources.push_back(Resource{"backbuffer", BACKBUFFER, {GL_NONE, GL_NONE, 1}, 0});
+        return (GraphResource) m_resources.size() - 1;
+    }
+
+    // a texture whose contents leave the graph, e.g. read back by the CPU; like the backbuffer,
+    // passes that write it are never culled
+    GraphResource importOutput(const char *name, GLuint texture) {
+        m_resources.push_back(Resource{name, OUTPUT, {GL_NONE, GL_NONE, 1}, texture});
+        return (GraphResource) m_resources.size() - 1;
+    }
+
+    // exists from its first to its last use in this frame, contents are undefined before the first write
+    GraphResource createTexture(const char *name, const GraphTextureDesc &desc) {
+        m_resources.push_back(Resource{name, TRANSIENT, desc, 0});
+        return (GraphResource) m_resources.size() - 1;
+    }
+
+    // setup(PassBuilder&) declares what the pass reads and writes, execute() runs it if the pass survives culling
+    template<typename Setup, typename Execute>
+    void addPass(const char *name, Setup &&setup, Execute &&execute) {
+        size_t firstRead = m_reads.size(), firstWrite = m_writes.size();
+        PassBuilder builder(&m_reads, &m_writes);
+        setup(builder);
+        m_passes.push_back(Pass{name, firstRead, m_reads.size(), firstWrite, m_writes.size(),
+                                PassFunction(std::forward<Execute>(execute)), false});
+    }
+
+    void compile() {
+        // culling, from the last pass back: a pass is needed if it writes the backbuffer, an output
+        // or something a needed pass reads
+        m_needed.assign(m_resources.size(), false);
+        for (size_t i = m_passes.size(); i-- > 0;) {
+            Pass &pass = m_passes[i];
+            pass.live = false;
+            for (size_t write = pass.firstWrite; write < pass.endWrite; ++write) {
+                GraphResource resource = m_writes[write];
+                if (m_needed[resource] || m_resources[resource].kind == BACKBUFFER ||
+                    m_resources[resource].kind == OUTPUT)
+                    pass.live = true;
+            }
+            if (pass.live)
+                for (size_t read = pass.firstRead; read < pass.endRead; ++read)
+                    m_needed[m_reads[read]] = true;
+        }
+
+        // lifetimes of the transients, in pass indices
+        for (Resource &resource : m_resources) {
+            resource.firstPass = -1;
+            resource.lastPass = -1;
+        }
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            if (!m_passes[i].live)
+                continue;
+            auto use = [&](GraphResource index) {
+                Resource &resource = m_resources[index];
+                if (resource.firstPass < 0)
+                    resource.firstPass = (int) i;
+                resource.lastPass = (int) i;
+            };
+            for (size_t read = m_passes[i].firstRead; read < m_passes[i].endRead; ++read)
+                use(m_reads[read]);
+            for (size_t write = m_passes[i].firstWrite; write < m_passes[i].endWrite; ++write)
+                use(m_writes[write]);
+        }
+
+        // walk the passes in order, take a free pooled texture of the same format when a transient
+        // starts and give it back after its last pass
+        for (Pooled &pooled : m_pool)
+            pooled.busy = false;
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            for (Resource &resource : m_resources)
+                if (resource.kind == TRANSIENT && resource.firstPass == (int) i)
+                    resource.pooled = acquire(resource.desc);
+            for (Resource &resource : m_resources)
+                if (resource.kind == TRANSIENT && resource.lastPass == (int) i)
+                    m_pool[resource.pooled].busy = false;
+        }
+        for (Resource &resource : m_resources) {
+            if (resource.kind == TRANSIENT && resource.firstPass >= 0)
+                resource.texture = m_pool[resource.pooled].texture;
+        }
+        releaseUnused();
+    }
+
+    // every live pass is a CPU profiler zone, and with a timer also a span of GPU time; the
+    // caller begins and ends the timer's frame
+    void execute(GpuPassTimer *timer = nullptr) {
+        for (const Pass &pass : m_passes) {
+            if (pass.live) {
+                DebugGroup group(pass.name);
+                ProfileZone zone(pass.name);
+                if (timer)
+                    timer->mark(pass.name);
+                pass.execute();
+            }
+        }
+    }
+
+    // GL texture behind a resource; transients only have one while their pass is live
+    GLuint texture(GraphResource resource) const {
+        return m_resources[resource].texture;
+    }
+
+    // binds a resource for sampling; transients are sampled with their own filter, whatever
+    // the other aliases of the texture use, imported textures with their texture parameters
+    void bindTexture(GLuint unit, GraphResource resource) {
+        const Resource &bound = m_resources[resource];
+        glState().bindTexture(unit, GL_TEXTURE_2D, bound.texture,
+                              bound.kind == TRANSIENT ? sampler(bound.desc.filter) : 0);
+    }
+
+    // framebuffer with the given color attachments, in order, and an optional depth texture;
+    // created on first use and cached
+    GLuint framebuffer(std::initializer_list<GraphResource> colors, GraphResource depth = GRAPH_NONE) {
+        // colors first, unused slots 0, depth last; a fixed size key, the lookup runs every pass
+        FramebufferKey key = {};
+        size_t colorCount = 0;
+        for (GraphResource color : colors)
+            if (colorCount < MAX_COLOR_ATTACHMENTS)
+                key[colorCount++] = texture(color);
+        key[MAX_COLOR_ATTACHMENTS] = depth == GRAPH_NONE ? 0 : texture(depth);
+        auto found = m_framebuffers.find(key);
+        if (found != m_framebuffers.end())
+            return found->second;
+
+        GLuint framebuffer;
+        glGenFramebuffers(1, &framebuffer);
+        glState().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (size_t i = 0; i < colorCount; ++i) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + (GLenum) i, GL_TEXTURE_2D, key[i], 0);
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum) i);
+        }
+        if (key[MAX_COLOR_ATTACHMENTS] != 0)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, key[MAX_COLOR_ATTACHMENTS], 0);
+        if (drawBuffers.empty())
+            glDrawBuffer(GL_NONE);
+        else
+            glDrawBuffers((GLsizei) drawBuffers.size(), drawBuffers.data());
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer of the render graph not complete!" << std::endl;
+        labelObject(GL_FRAMEBUFFER, framebuffer, "render graph framebuffer " + std::to_string(m_framebuffers.size()));
+        m_framebuffers[key] = framebuffer;
+        return framebuffer;
+    }
+
+    unsigned int passCount() const {
+        return (unsigned int) m_passes.size();
+    }
+
+    unsigned int culledPassCount() const {
+        unsigned int culled = 0;
+        for (const Pass &pass : m_passes)
+            culled += pass.live ? 0 : 1;
+        return culled;
+    }
+
+    // memory of the pooled textures used this frame
+    size_t transientBytes() const {
+        size_t bytes = 0;
+        for (const Pooled &pooled : m_pool)
+            if (pooled.lastFrame == m_frame)
+                bytes += textureBytes(pooled.internalFormat, pooled.downsample);
+        return bytes;
+    }
+
+    // what the live transients would take if each had its own texture
+    size_t transientBytesWithoutAliasing() const {
+        size_t bytes = 0;
+        for (const Resource &resource : m_resources)
+            if (resource.kind == TRANSIENT && resource.firstPass >= 0)
+                bytes += textureBytes(resource.desc.internalFormat, resource.desc.downsample);
+        return bytes;
+    }
+
+    void dump(std::ostream &out) const {
+        out << "Render graph, " << m_width << "x" << m_height << ", frame " << m_frame << '\n';
+        for (size_t i = 0; i < m_passes.size(); ++i) {
+            const Pass &pass = m_passes[i];
+            out << "  pass " << i << " " << pass.name << (pass.live ? "" : " (culled)") << '\n';
+            out << "    reads: ";
+            for (size_t read = pass.firstRead; read < pass.endRead; ++read)
+                out << m_resources[m_reads[read]].name << ' ';
+            out << "\n    writes: ";
+            for (size_t write = pass.firstWrite; write < pass.endWrite; ++write)
+                out << m_resources[m_writes[write]].name << ' ';
+            out << '\n';
+        }
+        for (const Resource &resource : m_resources) {
+            if (resource.kind != TRANSIENT)
+                continue;
+            char line[160];
+            if (resource.firstPass < 0)
+                std::snprintf(line, sizeof(line), "  transient %-16s format 0x%04x  unused\n", resource.name,
+                              resource.desc.internalFormat);
+            else
+                std::snprintf(line, sizeof(line),
+                              "  transient %-16s format 0x%04x  %-7s  1/%d  passes %d-%d  texture slot %d\n",
+                              resource.name, resource.desc.internalFormat,
+                              resource.desc.filter == GL_NEAREST ? "nearest" : "linear", resource.desc.downsample,
+                              resource.firstPass, resource.lastPass, resource.pooled);
+            out << line;
+        }
+        out << "  transient memory: " << transientBytes() / 1024 << " KiB, without aliasing "
+            << transientBytesWithoutAliasing() / 1024 << " KiB\n";
+    }
+
+private:
+    enum ResourceKind {
+        IMPORTED,
+        BACKBUFFER,
+        OUTPUT,
+        TRANSIENT
+    };
+
+    struct Resource {
+        const char *name;
+        ResourceKind kind;
+        GraphTextureDesc desc;
+        GLuint texture;
+        int firstPass = -1;
+        int lastPass = -1;
+        int pooled = -1;
+    };
+
+    // reads and writes are ranges of m_reads and m_writes, which keep their capacity between frames
+    struct Pass {
+        const char *name;
+        size_t firstRead;
+        size_t endRead;
+        size_t firstWrite;
+        size_t endWrite;
+        PassFunction execute;
+        bool live;
+    };
+
+    static const size_t MAX_COLOR_ATTACHMENTS = 8;
+    typedef std::array<GLuint, MAX_COLOR_ATTACHMENTS + 1> FramebufferKey;
+
+    struct Pooled {
+        GLuint texture;
+        GLenum internalFormat;
+        int downsample;
+        bool busy;
+        uint64_t lastFrame;
+    };
+
+    // textures nobody used for this many frames are deleted, e.g. the G-buffer after switching to forward
+    static const uint64_t UNUSED_FRAMES = 120;
+
+    size_t textureBytes(GLenum internalFormat, int downsample) const {
+        return bytesPerPixel(internalFormat) * downsampled(m_width, downsample) * downsampled(m_height, downsample);
+    }
+
+    static bool isDepthFormat(GLenum internalFormat) {
+        return internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24 ||
+               internalFormat == GL_DEPTH_COMPONENT32F;
+    }
+
+    int acquire(const GraphTextureDesc &desc) {
+        for (size_t i = 0; i < m_pool.size(); ++i) {
+            Pooled &pooled = m_pool[i];
+            if (!pooled.busy && pooled.internalFormat == desc.internalFormat && pooled.downsample == desc.downsample) {
+                pooled.busy = true;
+                pooled.lastFrame = m_frame;
+                return (int) i;
+            }
+        }
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glState().bindTexture(0, GL_TEXTURE_2D, texture);
+        int width = downsampled(m_width, desc.downsample), height = downsampled(m_height, desc.downsample);
+        if (isDepthFormat(desc.internalFormat))
+            glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        // no mipmaps, so the default filter would leave the texture incomplete; passes sample
+        // through bindTexture(), whose sampler overrides this
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // aliased by several resources, so named after the slot the dump prints
+        labelObject(GL_TEXTURE, texture, "render graph slot " + std::to_string(m_pool.size()));
+        m_pool.push_back(Pooled{texture, desc.internalFormat, desc.downsample, true, m_frame});
+        return (int) m_pool.size() - 1;
+    }
+
+    // one sampler object per filter, clamped like the pooled textures; created on first use
+    GLuint sampler(GLenum filter) {
+        for (const std::pair<GLenum, GLuint> &sampler : m_samplers)
+            if (sampler.first == filter)
+                return sampler.second;
+        GLuint sampler;
+        glGenSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, filter);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, filter);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        m_samplers.push_back(std::make_pair(filter, sampler));
+        return sampler;
+    }
+
+    void releaseUnused() {
+        bool released = false;
+        for (size_t i = m_pool.size(); i-- > 0;) {
+            if (m_frame - m_pool[i].lastFrame < UNUSED_FRAMES)
+                continue;
+            glDeleteTextures(1, &m_pool[i].texture);
+            m_pool.erase(m_pool.begin() + i);
+            released = true;
+        }
+        if (released) {
+            // pool indices moved, the slots of this frame's resources have to follow
+            for (Resource &resource : m_resources)
+                if (resource.kind == TRANSIENT && resource.firstPass >= 0)
+                    for (size_t i = 0; i < m_pool.size(); ++i)
+                        if (m_pool[i].texture == resource.texture)
+                            resource.pooled = (int) i;
+            releaseFramebuffers();
+        }
+    }
+
+    // deleting a bound object unbinds it behind the state cache's back, so the cache is reset
+    void releaseFramebuffers() {
+        for (auto &entry : m_framebuffers)
+            glDeleteFramebuffers(1, &entry.second);
+        m_framebuffers.clear();
+        glState().invalidate();
+    }
+
+    void releaseAll() {
+        for (Pooled &pooled : m_pool)
+            glDeleteTextures(1, &pooled.texture);
+        m_pool.clear();
+        releaseFramebuffers();
+    }
+
+    int m_width = 0;
+    int m_height = 0;
+    uint64_t m_frame = 0;
+    std::vector<Pass> m_passes;
+    std::vector<GraphResource> m_reads;
+    std::vector<GraphResource> m_writes;
+    std::vector<Resource> m_resources;
+    std::vector<bool> m_needed;
+    std::vector<Pooled> m_pool;
+    std::map<FramebufferKey, GLuint> m_framebuffers;
+    // (filter, sampler object)
+    std::vector<std::pair<GLenum, GLuint>> m_samplers;
+};
+
+};
+
+#endif //PROJECT_BASE_RENDERGRAPH_H
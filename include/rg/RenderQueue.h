@@ -0,0 +1,140 @@
+//
+// Draw packets with packed 64-bit sort keys. Scene code submits packets in any order,
+// the queue radix-sorts them by key and hands them back in draw order.
+//
+
+#ifndef PROJECT_BASE_RENDERQUEUE_H
+#define PROJECT_BASE_RENDERQUEUE_H
+
+#include <rg/FrameArena.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+// Passes run in order; inside a pass opaque geometry comes first, then the skybox,
+// then transparent geometry.
+enum RenderLayer {
+    LAYER_OPAQUE = 0,
+    LAYER_SKY = 1,
+    LAYER_TRANSPARENT = 2
+};
+
+// Key layout, most significant bits first:
+//   opaque and sky:  pass(4) | layer(2) | program(8) | material(16) | depth(24)           | unused(10)
+//   transparent:     pass(4) | layer(2) | inverted depth(24)         | program(8) | material(16) | unused(10)
+// Opaque draws are grouped by state and go front-to-back within a group, transparent
+// draws go strictly back-to-front.
+const unsigned int SORT_KEY_DEPTH_BITS = 24;
+
+// linear depth in [near, far] mapped to 24 bits
+inline uint32_t quantizeDepth(float viewDistance, float nearPlane, float farPlane) {
+    float normalized = (viewDistance - nearPlane) / (farPlane - nearPlane);
+    if (normalized < 0.0f)
+        normalized = 0.0f;
+    if (normalized > 1.0f)
+        normalized = 1.0f;
+    const uint32_t maxDepth = (1u << SORT_KEY_DEPTH_BITS) - 1;
+    return (uint32_t) (normalized * maxDepth);
+}
+
+inline uint64_t makeSortKey(unsigned int pass, RenderLayer layer, unsigned int program, unsigned int material,
+                            uint32_t depth) {
+    const uint32_t maxDepth = (1u << SORT_KEY_DEPTH_BITS) - 1;
+    uint64_t key = (uint64_t) (pass & 0xF) << 60 | (uint64_t) (layer & 0x3) << 58;
+    if (layer == LAYER_TRANSPARENT) {
+        key |= (uint64_t) (maxDepth - (depth & maxDepth)) << 34
+               | (uint64_t) (program & 0xFF) << 26
+               | (uint64_t) (material & 0xFFFF) << 10;
+    } else {
+        key |= (uint64_t) (program & 0xFF) << 50
+               | (uint64_t) (material & 0xFFFF) << 34
+               | (uint64_t) (depth & maxDepth) << 10;
+    }
+    return key;
+}
+
+inline unsigned int sortKeyPass(uint64_t key) {
+    return (unsigned int) (key >> 60);
+}
+
+struct DrawPacket {
+    uint64_t key;
+    // what to draw, interpreted by whoever executes the queue
+    uint32_t index;
+};
+
+class RenderQueue {
+public:
+    explicit RenderQueue(size_t expectedPackets = 256) {
+        m_packets.reserve(expectedPackets);
+    }
+
+    void clear() {
+        m_packets.clear();
+    }
+
+    void submit(uint64_t key, uint32_t index) {
+        m_packets.push_back(DrawPacket{key, index});
+    }
+
+    size_t size() const {
+        return m_packets.size();
+    }
+
+    // stable LSD radix sort on the key, one byte per pass; bytes that are equal in every key are
+    // skipped. The scratch copy comes from the frame arena
+    void sort() {
+        const size_t count = m_packets.size();
+        if (count < 2)
+            return;
+
+        DrawPacket *source = m_packets.data();
+        DrawPacket *destination = frameArena().allocateArray<DrawPacket>(count);
+        for (unsigned int shift = 0; shift < 64; shift += 8) {
+            size_t offsets[256];
+            std::memset(offsets, 0, sizeof(offsets));
+            for (size_t i = 0; i < count; ++i)
+                ++offsets[(source[i].key >> shift) & 0xFF];
+            if (offsets[(source[0].key >> shift) & 0xFF] == count)
+                continue;
+
+            size_t sum = 0;
+            for (size_t &offset : offsets) {
+                size_t bucket = offset;
+                offset = sum;
+                sum += bucket;
+            }
+            for (size_t i = 0; i < count; ++i)
+                destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+            std::swap(source, destination);
+        }
+        if (source != m_packets.data())
+            std::memcpy(m_packets.data(), source, count * sizeof(DrawPacket));
+    }
+
+    // calls draw(const DrawPacket&) for every packet in key order
+    template<typename DrawFunction>
+    void execute(DrawFunction &&draw) const {
+        for (const DrawPacket &packet : m_packets)
+            draw(packet);
+    }
+
+    // same, only for the packets of one pass
+    template<typename DrawFunction>
+    void executePass(unsigned int pass, DrawFunction &&draw) const {
+        for (const DrawPacket &packet : m_packets)
+            if (sortKeyPass(packet.key) == pass)
+                draw(packet);
+    }
+
+private:
+    std::vector<DrawPacket> m_packets;
+};
+
+};
+
+#endif //PROJECT_BASE_RENDERQUEUE_H
@@ -0,0 +1,188 @@
+//
+// Framebuffer with its own color textures and depth attachment, sized to the window.
+// resize() re-specifies the storage in place: texture and framebuffer names stay the same,
+// so anything that only holds the ids keeps working after a resize.
+//
+
+#ifndef PROJECT_BASE_RENDERTARGET_H
+#define PROJECT_BASE_RENDERTARGET_H
+
+#include <glad/glad.h>
+
+#include <rg/GLDebug.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// size of one pixel of a color or depth format, for memory and bandwidth estimates
+inline size_t bytesPerPixel(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_RGBA32F: return 16;
+        case GL_RGBA16F: return 8;
+        case GL_R16F: return 2;
+        case GL_R8: return 1;
+        // GL_RGBA8, GL_RG16F, GL_R11F_G11F_B10F, GL_R32F, GL_DEPTH_COMPONENT24
+        default: return 4;
+    }
+}
+
+struct ColorAttachment {
+    GLenum internalFormat;
+    GLenum filter;
+};
+
+enum DepthAttachment {
+    DEPTH_NONE,
+    // depth only has to be tested or blitted
+    DEPTH_RENDERBUFFER,
+    // depth is sampled later, e.g. to reconstruct positions
+    DEPTH_TEXTURE
+};
+
+class RenderTarget {
+public:
+    RenderTarget(const std::string &name, const std::vector<ColorAttachment> &colors, DepthAttachment depth)
+            : m_name(name), m_colors(colors), m_depth(depth) {
+        glGenFramebuffers(1, &m_framebuffer);
+        m_colorTextures.resize(colors.size());
+        if (!colors.empty())
+            glGenTextures((GLsizei) colors.size(), m_colorTextures.data());
+        if (depth == DEPTH_RENDERBUFFER)
+            glGenRenderbuffers(1, &m_depthBuffer);
+        else if (depth == DEPTH_TEXTURE)
+            glGenTextures(1, &m_depthBuffer);
+    }
+
+    ~RenderTarget() {
+        if (m_depth == DEPTH_RENDERBUFFER)
+            glDeleteRenderbuffers(1, &m_depthBuffer);
+        else if (m_depth == DEPTH_TEXTURE)
+            glDeleteTextures(1, &m_depthBuffer);
+        if (!m_colorTextures.empty())
+            glDeleteTextures((GLsizei) m_colorTextures.size(), m_colorTextures.data());
+        glDeleteFramebuffers(1, &m_framebuffer);
+    }
+
+    RenderTarget(const RenderTarget &) = delete;
+    RenderTarget &operator=(const RenderTarget &) = delete;
+
+    // attaches a color texture owned by another target after this target's own attachments, e.g.
+    // one buffer that several passes write into; has to be called before the first resize()
+    void shareColor(GLuint texture) {
+        m_sharedColors.push_back(texture);
+    }
+
+    // e.g. a narrower HDR format; takes effect right away if the storage exists. Changes GL
+    // bindings directly, like resize()
+    void setColorFormat(size_t index, GLenum internalFormat) {
+        m_colors[index].internalFormat = internalFormat;
+        if (m_width == 0)
+            return;
+        glBindTexture(GL_TEXTURE_2D, m_colorTextures[index]);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_width, m_height, 0, GL_RGBA, GL_FLOAT, NULL);
+    }
+
+    GLenum colorFormat(size_t index) const {
+        return m_colors[index].internalFormat;
+    }
+
+    // (re)allocates every attachment; changes GL bindings directly, the state cache has to be
+    // invalidated afterwards
+    void resize(int width, int height) {
+        if (width == m_width && height == m_height)
+            return;
+        bool attach = m_width == 0;
+        m_width = width;
+        m_height = height;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+        std::vector<GLenum> drawBuffers;
+        for (size_t i = 0; i < m_colors.size(); ++i) {
+            glBindTexture(GL_TEXTURE_2D, m_colorTextures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, m_colors[i].internalFormat, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+            if (attach) {
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_colors[i].filter);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_colors[i].filter);
+                // filters that read neighbours must not wrap around to the other edge
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_colorTextures[i], 0);
+                labelObject(GL_TEXTURE, m_colorTextures[i], m_name + " color " + std::to_string(i));
+            }
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + (GLenum) i);
+        }
+        for (GLuint texture : m_sharedColors) {
+            GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum) drawBuffers.size();
+            if (attach)
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+            drawBuffers.push_back(attachment);
+        }
+        if (m_depth == DEPTH_RENDERBUFFER) {
+            glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+            if (attach) {
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+                labelObject(GL_RENDERBUFFER, m_depthBuffer, m_name + " depth");
+            }
+        } else if (m_depth == DEPTH_TEXTURE) {
+            glBindTexture(GL_TEXTURE_2D, m_depthBuffer);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+            if (attach) {
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthBuffer, 0);
+                labelObject(GL_TEXTURE, m_depthBuffer, m_name + " depth");
+            }
+        }
+        if (attach) {
+            labelObject(GL_FRAMEBUFFER, m_framebuffer, m_name);
+            if (drawBuffers.empty())
+                glDrawBuffer(GL_NONE);
+            else
+                glDrawBuffers((GLsizei) drawBuffers.size(), drawBuffers.data());
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer " << m_name << " not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    GLuint framebuffer() const {
+        return m_framebuffer;
+    }
+
+    GLuint colorTexture(size_t index) const {
+        return m_colorTextures[index];
+    }
+
+    // texture or renderbuffer, depending on the depth attachment
+    GLuint depthBuffer() const {
+        return m_depthBuffer;
+    }
+
+    int width() const {
+        return m_width;
+    }
+
+    int height() const {
+        return m_height;
+    }
+
+private:
+    std::string m_name;
+    std::vector<ColorAttachment> m_colors;
+    DepthAttachment m_depth;
+
+    GLuint m_framebuffer = 0;
+    std::vector<GLuint> m_colorTextures;
+    std::vector<GLuint> m_sharedColors;
+    GLuint m_depthBuffer = 0;
+    int m_width = 0;
+    int m_height = 0;
+};
+
+};
+
+#endif //PROJECT_BASE_RENDERTARGET_H
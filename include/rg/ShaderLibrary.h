@@ -0,0 +1,227 @@
+//
+// Shader permutations: sources are assembled from shared chunks (#include "file")
+// and specialized with #define lines, every variant is compiled once and cached by key.
+// Programs can be requested in a batch and collected together, so the driver compiles them in parallel.
+//
+
+#ifndef PROJECT_BASE_SHADERLIBRARY_H
+#define PROJECT_BASE_SHADERLIBRARY_H
+
+#include <learnopengl/shader.h>
+#include <common.h>
+#include <rg/GLDebug.h>
+#include <rg/ProgramBinaryCache.h>
+#include <rg/StartupTimeline.h>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// reads a shader file and replaces every #include "file" line with that file, relative to the includer
+inline std::string loadShaderSource(const std::string &path, int depth = 0) {
+    std::string source = readFileContents(path);
+    if (source.empty())
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << '\n';
+    if (depth > 8) {
+        std::cerr << "ERROR::SHADER::INCLUDE_TOO_DEEP " << path << '\n';
+        return source;
+    }
+
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
+    std::stringstream in(source);
+    std::string result;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t directive = line.find("#include");
+        size_t open = line.find('"');
+        size_t close = line.rfind('"');
+        if (directive != std::string::npos && open != std::string::npos && close > open) {
+            result += loadShaderSource(directory + line.substr(open + 1, close - open - 1), depth + 1);
+            result += '\n';
+        } else {
+            result += line;
+            result += '\n';
+        }
+    }
+    return result;
+}
+
+// inserts "#define <define>" for every entry right after the #version line
+inline std::string specializeShaderSource(const std::string &source, const std::vector<std::string> &defines) {
+    std::string block;
+    for (const std::string &define : defines)
+        block += "#define " + define + '\n';
+
+    size_t version = source.find("#version");
+    size_t insertAt = version == std::string::npos ? 0 : source.find('\n', version);
+    if (insertAt == std::string::npos)
+        return source + '\n' + block;
+    if (version != std::string::npos)
+        ++insertAt;
+    return source.substr(0, insertAt) + block + source.substr(insertAt);
+}
+
+inline std::string shaderVariantKey(const std::string &vertexPath, const std::string &fragmentPath,
+                                    const std::vector<std::string> &defines) {
+    std::string key = vertexPath + '|' + fragmentPath;
+    for (const std::string &define : defines)
+        key += '|' + define;
+    return key;
+}
+
+class ShaderLibrary {
+public:
+    // without a cache every variant is compiled from source
+    explicit ShaderLibrary(ProgramBinaryCache *binaryCache = nullptr)
+            : m_binaryCache(binaryCache) {
+    }
+
+    // returns the compiled variant, building it on first request; the reference stays valid
+    // for the lifetime of the library
+    Shader &get(const std::string &vertexPath, const std::string &fragmentPath,
+                const std::vector<std::string> &defines = std::vector<std::string>()) {
+        Shader &shader = request(vertexPath, fragmentPath, defines);
+        finish();
+        return shader;
+    }
+
+    // like get(), but the program may still be compiling; it must not be used before finish()
+    Shader &request(const std::string &vertexPath, const std::string &fragmentPath,
+                    const std::vector<std::string> &defines = std::vector<std::string>()) {
+        std::string key = shaderVariantKey(vertexPath, fragmentPath, defines);
+        auto found = m_programs.find(key);
+        if (found != m_programs.end())
+            return *found->second;
+        // variants of the same files are told apart by the order they were requested in
+        ScopedStartupPhase phase("shader " + fileName(vertexPath) + '/' + fileName(fragmentPath) + " #" +
+                                 std::to_string(m_programs.size()));
+
+        std::string vertexCode = specializeShaderSource(loadShaderSource(vertexPath), defines);
+        std::string fragmentCode = specializeShaderSource(loadShaderSource(fragmentPath), defines);
+
+        std::unique_ptr<Shader> shader(new Shader());
+        uint64_t binaryKey = 0;
+        if (m_binaryCache) {
+            binaryKey = m_binaryCache->key(vertexCode, fragmentCode);
+            shader->ID = m_binaryCache->load(binaryKey);
+        }
+        if (shader->ID == 0) {
+            shader->beginCompile(vertexCode.c_str(), fragmentCode.c_str());
+            m_pending.push_back(PendingProgram{shader.get(), binaryKey});
+        }
+        labelObject(GL_PROGRAM, shader->ID, key);
+        Shader &result = *shader;
+        m_programs.emplace(key, std::move(shader));
+        return result;
+    }
+
+    // collects every requested program, the ones the driver finished first are handled first
+    void finish() {
+        while (!m_pending.empty()) {
+            bool progressed = false;
+            for (size_t i = 0; i < m_pending.size();) {
+                if (m_pending[i].shader->isCompileReady()) {
+                    complete(m_pending[i]);
+                    m_pending.erase(m_pending.begin() + i);
+                    progressed = true;
+                } else {
+                    ++i;
+                }
+            }
+            // nothing is ready yet, wait on the oldest job
+            if (!progressed) {
+                complete(m_pending.front());
+                m_pending.erase(m_pending.begin());
+            }
+        }
+    }
+
+    // Draws one triangle with every program into a 1x1 target with the given color attachment
+    // formats, in order, and optionally a depth buffer, so drivers that compile lazily on first
+    // use, or specialize programs on the output formats, do it now instead of in the first
+    // frames. No color formats is a depth-only target. Changes GL state directly, the state cache
+    // has to be invalidated afterwards.
+    void prewarm(const std::vector<GLenum> &colorFormats, bool depthBuffer = true) {
+        finish();
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        const GLsizei colorAttachments = (GLsizei) colorFormats.size();
+        GLuint framebuffer, depth = 0, vertexArray;
+        std::vector<GLuint> colors(colorAttachments);
+        std::vector<GLenum> drawBuffers(colorAttachments);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenTextures(colorAttachments, colors.data());
+        for (GLsizei i = 0; i < colorAttachments; ++i) {
+            glBindTexture(GL_TEXTURE_2D, colors[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, colorFormats[i], 1, 1, 0, GL_RGBA, GL_FLOAT, NULL);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colors[i], 0);
+            drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        if (colorAttachments > 0)
+            glDrawBuffers(colorAttachments, drawBuffers.data());
+        else
+            glDrawBuffer(GL_NONE);
+        if (depthBuffer) {
+            glGenRenderbuffers(1, &depth);
+            glBindRenderbuffer(GL_RENDERBUFFER, depth);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 1, 1);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        }
+        // attributes the programs read come from the current generic values
+        glGenVertexArrays(1, &vertexArray);
+        glBindVertexArray(vertexArray);
+        glViewport(0, 0, 1, 1);
+
+        for (auto &program : m_programs) {
+            glUseProgram(program.second->ID);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        glFinish();
+
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glUseProgram(0);
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteVertexArrays(1, &vertexArray);
+        if (depth != 0)
+            glDeleteRenderbuffers(1, &depth);
+        glDeleteTextures(colorAttachments, colors.data());
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+
+    size_t size() const {
+        return m_programs.size();
+    }
+
+private:
+    static std::string fileName(const std::string &path) {
+        return path.substr(path.find_last_of('/') + 1);
+    }
+
+    struct PendingProgram {
+        Shader *shader;
+        uint64_t binaryKey;
+    };
+
+    void complete(const PendingProgram &pending) {
+        pending.shader->finishCompile();
+        if (m_binaryCache)
+            m_binaryCache->store(pending.binaryKey, pending.shader->ID);
+    }
+
+    ProgramBinaryCache *m_binaryCache;
+    std::vector<PendingProgram> m_pending;
+    std::map<std::string, std::unique_ptr<Shader>> m_programs;
+};
+
+};
+
+#endif //PROJECT_BASE_SHADERLIBRARY_H
@@ -0,0 +1,280 @@
+//
+// Cascaded shadow maps for the directional light. The view range up to the shadow distance is
+// split into cascades, each fitted with a texel-snapped orthographic projection. Static casters
+// are rendered into a cache that is reused while the cascade does not move; every frame the cache
+// is copied into the live map and only the moving casters are drawn on top.
+//
+
+#ifndef PROJECT_BASE_SHADOWCASCADES_H
+#define PROJECT_BASE_SHADOWCASCADES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader.h>
+#include <rg/Frustum.h>
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// size of the uniform arrays, also passed to the shaders as a define (see ShadowCascades::shaderDefines)
+const int MAX_SHADOW_CASCADES = 3;
+
+// texture unit of the shadow map array, after the light cluster units
+const unsigned int SHADOW_TEXTURE_UNIT = 19;
+
+struct ShadowSettings {
+    bool enabled = true;
+    int cascades = 3;
+    // width and height of every cascade
+    int resolution = 1024;
+    // the shader takes (2 * pcfRadius + 1)^2 filtered samples
+    int pcfRadius = 1;
+    // view distance at which shadows end
+    float distance = 30.0f;
+    // 0 splits the range evenly, 1 logarithmically
+    float splitLambda = 0.75f;
+};
+
+class ShadowCascades {
+public:
+    ShadowCascades() {
+        glGenFramebuffers(LAYERS, m_framebuffers);
+        glGenTextures(LAYERS, m_textures);
+        for (int i = 0; i < MAX_SHADOW_CASCADES; ++i) {
+            m_lightSpace[i] = glm::mat4(1.0f);
+            m_staticValid[i] = false;
+        }
+    }
+
+    ~ShadowCascades() {
+        glDeleteTextures(LAYERS, m_textures);
+        glDeleteFramebuffers(LAYERS, m_framebuffers);
+    }
+
+    ShadowCascades(const ShadowCascades &) = delete;
+    ShadowCascades &operator=(const ShadowCascades &) = delete;
+
+    static std::vector<std::string> shaderDefines() {
+        return {"SHADOW_CASCADES " + std::to_string(MAX_SHADOW_CASCADES)};
+    }
+
+    // once per program that includes lighting.glsl; the program has to be in use
+    static void configureSamplers(const Shader &shader) {
+        shader.setInt("shadowMap", SHADOW_TEXTURE_UNIT);
+    }
+
+    // fits the cascades to the camera for this frame; fovY in radians
+    void update(const ShadowSettings &settings, const glm::mat4 &view, float fovY, float aspect, float nearPlane,
+                const glm::vec3 &lightDirection) {
+        m_settings = settings;
+        m_count = settings.enabled ? std::min(std::max(settings.cascades, 1), MAX_SHADOW_CASCADES) : 0;
+        if (m_count == 0)
+            return;
+        if (settings.resolution != m_resolution)
+            allocate(settings.resolution);
+
+        // practical split scheme: a blend of uniform and logarithmic splits
+        float farPlane = std::max(settings.distance, nearPlane * 2.0f);
+        float splits[MAX_SHADOW_CASCADES + 1];
+        splits[0] = nearPlane;
+        for (int i = 1; i <= m_count; ++i) {
+            float p = (float) i / m_count;
+            float logarithmic = nearPlane * std::pow(farPlane / nearPlane, p);
+            float uniform = nearPlane + (farPlane - nearPlane) * p;
+            splits[i] = settings.splitLambda * logarithmic + (1.0f - settings.splitLambda) * uniform;
+        }
+
+        glm::vec3 direction = glm::normalize(lightDirection);
+        glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+        glm::mat4 inverseView = glm::inverse(view);
+        float tanY = std::tan(fovY * 0.5f);
+        float tanX = tanY * aspect;
+
+        for (int i = 0; i < m_count; ++i) {
+            // bounding sphere of the slice, in view space it is centered on the view axis, so its
+            // size does not change when the camera turns
+            float sliceNear = splits[i], sliceFar = splits[i + 1];
+            float centerDepth = (sliceNear + sliceFar) * 0.5f;
+            float radius = 0.0f;
+            const float depths[2] = {sliceNear, sliceFar};
+            for (float d : depths)
+                radius = std::max(radius, glm::length(glm::vec3(d * tanX, d * tanY, centerDepth - d)));
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+            glm::vec3 center = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+
+            // move the projection in whole texels only, so static shadows do not shimmer and the
+            // cache stays valid while the camera moves less than a texel
+            float texel = 2.0f * radius / m_resolution;
+            glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+            lightCenter = glm::floor(lightCenter / texel) * texel;
+            glm::mat4 projection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius,
+                                              lightCenter.y - radius, lightCenter.y + radius,
+                                              -lightCenter.z - radius - CASTER_MARGIN, -lightCenter.z + radius);
+            glm::mat4 lightSpace = projection * lightView;
+
+            if (lightSpace != m_lightSpace[i])
+                m_staticValid[i] = false;
+            m_lightSpace[i] = lightSpace;
+            m_splits[i] = sliceFar;
+            m_texelSizes[i] = texel;
+        }
+    }
+
+    // renders the cascades; drawCasters(bool staticCasters, const glm::mat4 &lightSpace,
+    // const Frustum &bounds) draws the casters of one kind that intersect bounds and returns the
+    // number of draws. The framebuffer and viewport have to be restored by the caller.
+    template<typename DrawCasters>
+    void render(DrawCasters &&drawCasters) {
+        m_staticRefreshes = 0;
+        m_draws = 0;
+        if (m_count == 0)
+            return;
+
+        glViewport(0, 0, m_resolution, m_resolution);
+        glState().enable(GL_DEPTH_TEST);
+        glState().depthMask(GL_TRUE);
+        glState().depthFunc(GL_LESS);
+        glState().disable(GL_CULL_FACE);
+        // casters in front of the near plane are clamped onto it instead of clipped away
+        glState().enable(GL_DEPTH_CLAMP);
+        glState().enable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.5f, 2.0f);
+
+        for (int i = 0; i < m_count; ++i) {
+            Frustum bounds(m_lightSpace[i]);
+            if (!m_staticValid[i]) {
+                attach(STATIC, i);
+                glState().bindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[STATIC]);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                m_draws += drawCasters(true, m_lightSpace[i], bounds);
+                m_staticValid[i] = true;
+                ++m_staticRefreshes;
+            }
+
+            attach(STATIC, i);
+            attach(LIVE, i);
+            glState().bindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffers[STATIC]);
+            glState().bindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffers[LIVE]);
+            glBlitFramebuffer(0, 0, m_resolution, m_resolution, 0, 0, m_resolution, m_resolution,
+                              GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            glState().bindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[LIVE]);
+            m_draws += drawCasters(false, m_lightSpace[i], bounds);
+        }
+
+        glState().disable(GL_POLYGON_OFFSET_FILL);
+        glState().disable(GL_DEPTH_CLAMP);
+    }
+
+    // drops the static cache, e.g. when static geometry changed
+    void invalidateStatic() {
+        for (int i = 0; i < MAX_SHADOW_CASCADES; ++i)
+            m_staticValid[i] = false;
+    }
+
+    void bind() const {
+        glState().bindTexture(SHADOW_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, m_textures[LIVE]);
+    }
+
+    void setUniforms(const Shader &shader) const {
+        shader.setInt("shadowCascadeCount", m_count);
+        shader.setInt("shadowPcfRadius", m_settings.pcfRadius);
+        if (m_count == 0)
+            return;
+        // whole arrays at once, no per-element names to build every frame
+        shader.setMat4Array("shadowMatrices", m_lightSpace, m_count);
+        shader.setFloatArray("shadowSplits", m_splits, m_count);
+        shader.setFloatArray("shadowTexelSizes", m_texelSizes, m_count);
+    }
+
+    // the live map, the one the scene samples
+    GLuint texture() const {
+        return m_textures[LIVE];
+    }
+
+    int cascadeCount() const {
+        return m_count;
+    }
+
+    // cascades whose static cache was re-rendered in the last render()
+    unsigned int staticRefreshes() const {
+        return m_staticRefreshes;
+    }
+
+    unsigned int draws() const {
+        return m_draws;
+    }
+
+private:
+    // static cache and live map, each a depth texture array with one layer per cascade
+    enum Layer {
+        STATIC = 0,
+        LIVE = 1,
+        LAYERS = 2
+    };
+
+    // how far behind a cascade, towards the light, casters are still rendered
+    static constexpr float CASTER_MARGIN = 20.0f;
+
+    void allocate(int resolution) {
+        m_resolution = resolution;
+        for (int layer = 0; layer < LAYERS; ++layer) {
+            glState().bindTexture(SHADOW_TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, m_textures[layer]);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, MAX_SHADOW_CASCADES,
+                         0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+            // hardware comparison with bilinear filtering, outside the map everything is lit
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+            float border[] = {1.0f, 1.0f, 1.0f, 1.0f};
+            glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+            glState().bindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[layer]);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+            const char *name = layer == STATIC ? "shadow cascades static" : "shadow cascades live";
+            labelObject(GL_TEXTURE, m_textures[layer], name);
+            labelObject(GL_FRAMEBUFFER, m_framebuffers[layer], name);
+        }
+        m_attached[STATIC] = m_attached[LIVE] = -1;
+        invalidateStatic();
+    }
+
+    void attach(Layer layer, int cascade) {
+        if (m_attached[layer] == cascade)
+            return;
+        glState().bindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[layer]);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_textures[layer], 0, cascade);
+        m_attached[layer] = cascade;
+    }
+
+    GLuint m_framebuffers[LAYERS];
+    GLuint m_textures[LAYERS];
+    int m_attached[LAYERS] = {-1, -1};
+    int m_resolution = 0;
+
+    ShadowSettings m_settings;
+    int m_count = 0;
+    glm::mat4 m_lightSpace[MAX_SHADOW_CASCADES];
+    float m_splits[MAX_SHADOW_CASCADES] = {};
+    float m_texelSizes[MAX_SHADOW_CASCADES] = {};
+    bool m_staticValid[MAX_SHADOW_CASCADES];
+
+    unsigned int m_staticRefreshes = 0;
+    unsigned int m_draws = 0;
+};
+
+};
+
+#endif //PROJECT_BASE_SHADOWCASCADES_H
@@ -0,0 +1,149 @@
+//
+// Startup timeline: named, nested phases from the start of main until the first frame is
+// presented. The report is printed every launch; the tab separated form is what the startup
+// benchmark reads back from the runs it launches.
+//
+
+#ifndef PROJECT_BASE_STARTUPTIMELINE_H
+#define PROJECT_BASE_STARTUPTIMELINE_H
+
+#include <chrono>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+struct StartupPhase {
+    std::string name;
+    // 0 for phases that are not inside another phase
+    int depth;
+    // from the start of the timeline
+    double startMilliseconds;
+    double milliseconds;
+};
+
+class StartupTimeline {
+public:
+    // the clock starts here, so the first use has to be the first thing main does
+    StartupTimeline()
+            : m_start(Clock::now()) {
+    }
+
+    // returns the handle end() takes; after finish() nothing is recorded anymore, so code that
+    // also runs later, e.g. a shader requested at runtime, may open phases unconditionally
+    int begin(const std::string &name) {
+        if (m_finished)
+            return -1;
+        m_phases.push_back(StartupPhase{name, m_depth++, elapsed(), 0.0});
+        return (int) m_phases.size() - 1;
+    }
+
+    void end(int phase) {
+        if (phase < 0)
+            return;
+        StartupPhase &sample = m_phases[phase];
+        sample.milliseconds = elapsed() - sample.startMilliseconds;
+        --m_depth;
+    }
+
+    // the first frame has been presented
+    void finish() {
+        if (m_finished)
+            return;
+        m_total = elapsed();
+        m_finished = true;
+    }
+
+    bool finished() const {
+        return m_finished;
+    }
+
+    // time to the first frame, once finished
+    double totalMilliseconds() const {
+        return m_total;
+    }
+
+    const std::vector<StartupPhase> &phases() const {
+        return m_phases;
+    }
+
+    double elapsed() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - m_start).count();
+    }
+
+    void report(std::ostream &out) const {
+        char line[256];
+        std::snprintf(line, sizeof(line), "Startup: %.1f ms to the first frame\n", m_total);
+        out << line;
+        for (const StartupPhase &phase : m_phases) {
+            std::snprintf(line, sizeof(line), "  %9.3f ms  (at %9.3f)  %*s%s\n", phase.milliseconds,
+                          phase.startMilliseconds, phase.depth * 2, "", phase.name.c_str());
+            out << line;
+        }
+    }
+
+    // "startup-phase<TAB>depth<TAB>ms<TAB>name" per phase, the total as the phase "total"
+    void write(std::ostream &out) const {
+        for (const StartupPhase &phase : m_phases)
+            out << "startup-phase\t" << phase.depth << '\t' << phase.milliseconds << '\t' << phase.name << '\n';
+        out << "startup-phase\t0\t" << m_total << "\ttotal\n";
+    }
+
+    // the phases write() produced, other lines are skipped
+    static std::vector<StartupPhase> read(std::istream &in) {
+        std::vector<StartupPhase> phases;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string tag;
+            StartupPhase phase{std::string(), 0, 0.0, 0.0};
+            if (!std::getline(fields, tag, '\t') || tag != "startup-phase")
+                continue;
+            fields >> phase.depth >> phase.milliseconds;
+            fields.ignore(1);
+            if (fields && std::getline(fields, phase.name))
+                phases.push_back(phase);
+        }
+        return phases;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point m_start;
+    std::vector<StartupPhase> m_phases;
+    int m_depth = 0;
+    double m_total = 0.0;
+    bool m_finished = false;
+};
+
+inline StartupTimeline &startupTimeline() {
+    static StartupTimeline timeline;
+    return timeline;
+}
+
+// one phase for the lifetime of the object
+class ScopedStartupPhase {
+public:
+    explicit ScopedStartupPhase(const std::string &name)
+            : m_phase(startupTimeline().begin(name)) {
+    }
+
+    ~ScopedStartupPhase() {
+        startupTimeline().end(m_phase);
+    }
+
+    ScopedStartupPhase(const ScopedStartupPhase &) = delete;
+    ScopedStartupPhase &operator=(const ScopedStartupPhase &) = delete;
+
+private:
+    int m_phase;
+};
+
+};
+
+#endif //PROJECT_BASE_STARTUPTIMELINE_H
@@ -0,0 +1,96 @@
+//
+// Temporal anti-aliasing: every frame the projection is shifted by a different sub-pixel offset
+// and the resolve pass (resources/shaders/taa.fs) accumulates the frames in a window-sized history,
+// reprojected with per-object motion vectors. Because the history has the window's resolution,
+// the same pass also upsamples a scene rendered at a lower resolution.
+//
+
+#ifndef PROJECT_BASE_TEMPORALAA_H
+#define PROJECT_BASE_TEMPORALAA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <rg/RenderTarget.h>
+
+#include <cstdint>
+
+namespace rg {
+
+// element index of the Halton sequence with the given base, in [0, 1)
+inline float halton(uint32_t index, uint32_t base) {
+    float result = 0.0f;
+    float fraction = 1.0f / base;
+    for (; index > 0; index /= base) {
+        result += fraction * (index % base);
+        fraction /= base;
+    }
+    return result;
+}
+
+// sub-pixel offset of the frame in pixels, in [-0.5, 0.5); 8 points of the Halton (2, 3) sequence
+inline glm::vec2 taaJitter(uint32_t frame) {
+    uint32_t index = frame % 8 + 1;
+    return glm::vec2(halton(index, 2), halton(index, 3)) - glm::vec2(0.5f);
+}
+
+// moves everything the projection renders by jitter pixels of a renderSize viewport
+inline glm::mat4 jitterProjection(const glm::mat4 &projection, const glm::vec2 &jitter, const glm::ivec2 &renderSize) {
+    glm::mat4 result = projection;
+    result[2][0] += jitter.x * 2.0f / renderSize.x;
+    result[2][1] += jitter.y * 2.0f / renderSize.y;
+    return result;
+}
+
+class TemporalAA {
+public:
+    TemporalAA()
+            : m_history{{"TAA history 0", {{GL_RGBA16F, GL_LINEAR}}, DEPTH_NONE},
+                        {"TAA history 1", {{GL_RGBA16F, GL_LINEAR}}, DEPTH_NONE}} {
+    }
+
+    // window size; the old history does not fit anymore
+    void resize(int width, int height) {
+        m_history[0].resize(width, height);
+        m_history[1].resize(width, height);
+        m_valid = false;
+    }
+
+    // e.g. after TAA was turned back on, the history is stale
+    void reset() {
+        m_valid = false;
+    }
+
+    bool historyValid() const {
+        return m_valid;
+    }
+
+    // result of the previous resolve
+    GLuint historyTexture() const {
+        return m_history[m_current ^ 1].colorTexture(0);
+    }
+
+    // where this frame's resolve writes
+    GLuint outputFramebuffer() const {
+        return m_history[m_current].framebuffer();
+    }
+
+    GLuint outputTexture() const {
+        return m_history[m_current].colorTexture(0);
+    }
+
+    // after the resolve: this frame's output becomes the next frame's history
+    void advance() {
+        m_current ^= 1;
+        m_valid = true;
+    }
+
+private:
+    RenderTarget m_history[2];
+    unsigned int m_current = 0;
+    bool m_valid = false;
+};
+
+};
+
+#endif //PROJECT_BASE_TEMPORALAA_H
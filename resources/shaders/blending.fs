@@ -1,8 +1,7 @@
 #version 330 core
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
-
 
+#include "motion_fragment.glsl"
 
 in vec2 TexCoords;
 
@@ -14,12 +13,6 @@ void main()
     if (texColor.a < 0.1)
         discard;
 
-    float brightness = dot(texColor.xyz, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 1.0)
-       BrightColor = vec4(texColor);
-    else
-       BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
-
-
- FragColor = texColor;
-}
\ No newline at end of file
+    FragColor = texColor;
+    writeMotion(texColor.a);
+}
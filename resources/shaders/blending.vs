@@ -9,9 +9,13 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+#include "motion_vertex.glsl"
+
 void main() {
 
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4 (aPos, 1.0);
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+    writeMotion(worldPos.xyz, aPos);
 
 }
\ No newline at end of file
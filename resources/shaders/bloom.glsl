@@ -0,0 +1,7 @@
+// Prag za bloom: u bloom idu samo delovi svetliji od 1.0, ostalo je crno.
+
+vec3 brightPass(vec3 color)
+{
+    float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    return brightness > 1.0 ? color : vec3(0.0);
+}
@@ -6,26 +6,30 @@ in vec2 TexCoords;
 uniform sampler2D image;
 
 uniform bool horizontal;
+// popunjeni deo teksture, van njega su ostaci vecih rezolucija
+uniform vec2 uvScale;
 uniform float weight[5] = float[] (0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162);
 
 void main()
 {
      vec2 tex_offset = 1.0 / textureSize(image, 0); // gets size of single texel
-     vec3 result = texture(image, TexCoords).rgb * weight[0];
+     vec2 uv = TexCoords * uvScale;
+     vec2 uvMax = uvScale - 0.5 * tex_offset;
+     vec3 result = texture(image, uv).rgb * weight[0];
      if(horizontal)
      {
          for(int i = 1; i < 5; ++i)
          {
-            result += texture(image, TexCoords + vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
-            result += texture(image, TexCoords - vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
+            result += texture(image, min(uv + vec2(tex_offset.x * i, 0.0), uvMax)).rgb * weight[i];
+            result += texture(image, uv - vec2(tex_offset.x * i, 0.0)).rgb * weight[i];
          }
      }
      else
      {
          for(int i = 1; i < 5; ++i)
          {
-             result += texture(image, TexCoords + vec2(0.0, tex_offset.y * i)).rgb * weight[i];
-             result += texture(image, TexCoords - vec2(0.0, tex_offset.y * i)).rgb * weight[i];
+             result += texture(image, min(uv + vec2(0.0, tex_offset.y * i), uvMax)).rgb * weight[i];
+             result += texture(image, uv - vec2(0.0, tex_offset.y * i)).rgb * weight[i];
          }
      }
      FragColor = vec4(result, 1.0);
@@ -0,0 +1,33 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+#include "bloom.glsl"
+
+// HDR slika scene
+uniform sampler2D scene;
+// popunjeni deo teksture scene; prolaz se crta u odgovarajuci deo bloom teksture
+uniform vec2 uvScale;
+// koliko piksela scene pokriva jedan piksel bloom-a po osi: 1, 2 ili 4
+uniform int downsample;
+
+void main()
+{
+    vec2 uv = TexCoords * uvScale;
+    if (downsample <= 1) {
+        FragColor = vec4(brightPass(texture(scene, uv).rgb), 1.0);
+        return;
+    }
+
+    // cetiri uzorka pokrivaju downsample x downsample piksela scene; prag se primenjuje na svaki,
+    // da se jedan jak piksel ne izgubi u proseku sa tamnim susedima
+    vec2 texel = 1.0 / vec2(textureSize(scene, 0));
+    vec2 offset = texel * (float(downsample) * 0.25);
+    vec2 uvMax = uvScale - 0.5 * texel;
+    vec3 result = brightPass(texture(scene, clamp(uv + vec2(-offset.x, -offset.y), vec2(0.0), uvMax)).rgb);
+    result += brightPass(texture(scene, clamp(uv + vec2(offset.x, -offset.y), vec2(0.0), uvMax)).rgb);
+    result += brightPass(texture(scene, clamp(uv + vec2(-offset.x, offset.y), vec2(0.0), uvMax)).rgb);
+    result += brightPass(texture(scene, clamp(uv + vec2(offset.x, offset.y), vec2(0.0), uvMax)).rgb);
+    FragColor = vec4(result * 0.25, 1.0);
+}
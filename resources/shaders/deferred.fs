@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+
+// Odlozeno osvetljenje: jednom po pikselu, iz G-bafera, u isti hdrFBO kao forward prolaz
+#include "gbuffer.glsl"
+#include "lighting.glsl"
+
+in vec2 TexCoords;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gSpecular;
+uniform sampler2D gDepth;
+// iz NDC nazad u svet
+uniform mat4 inverseViewProjection;
+// popunjeni deo G-bafera, kao u final.fs
+uniform vec2 uvScale;
+
+void main()
+{
+    vec2 uv = TexCoords * uvScale;
+    float depth = texture(gDepth, uv).r;
+    // tu nista nije iscrtano, ostaje nebo
+    if (depth == 1.0)
+        discard;
+
+    vec4 ndc = vec4(TexCoords * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = inverseViewProjection * ndc;
+    vec3 fragPos = world.xyz / world.w;
+
+    Surface surface = readGBuffer(texture(gAlbedo, uv), texture(gSpecular, uv));
+    vec3 normal = texture(gNormal, uv).xyz;
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 result = calcLighting(surface, normal, fragPos, viewDir, depth);
+
+    FragColor = vec4(result, 1.0);
+}
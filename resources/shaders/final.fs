@@ -7,15 +7,42 @@ uniform sampler2D scene; //iz koje semplujemo celu scenu
 uniform sampler2D bloomBlur; // blur
 uniform bool bloom;
 uniform float exposure;
+// scena je iscrtana u donji levi deo tekstura, ovoliki deo je popunjen
+uniform vec2 uvScale;
+// isto za bloom, koji ostaje u rezoluciji scene i kada TAA uveca scenu
+uniform vec2 bloomUvScale;
+// jacina izostravanja pri uvecanju, 0 iskljucuje
+uniform float sharpness;
+// za FXAA: u alfa kanal ide osvetljenost tonemapovane boje
+uniform bool lumaInAlpha;
+
+vec3 toneMap(vec3 hdrColor)
+{
+    return vec3(1.0) - exp(-hdrColor * exposure);
+}
 
 void main()
 {
-    vec3 hdrColor = texture(scene, TexCoords).rgb;
-    vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
-    if(bloom)
-        hdrColor += bloomColor;
+    vec2 uv = TexCoords * uvScale;
+    vec3 bloomColor = bloom ? texture(bloomBlur, TexCoords * bloomUvScale).rgb : vec3(0.0);
+    vec3 result = toneMap(texture(scene, uv).rgb + bloomColor);
+
+    if (sharpness > 0.0) {
+        // adaptivno izostravanje (po uzoru na AMD CAS): krst suseda na razmaku jednog teksela,
+        // tamo gde je kontrast vec veliki izostrava se manje, da ne bi nastali oreoli
+        vec2 texel = 1.0 / vec2(textureSize(scene, 0));
+        vec2 uvMax = uvScale - 0.5 * texel;
+        vec3 north = toneMap(texture(scene, min(uv + vec2(0.0, texel.y), uvMax)).rgb + bloomColor);
+        vec3 south = toneMap(texture(scene, max(uv - vec2(0.0, texel.y), vec2(0.0))).rgb + bloomColor);
+        vec3 east = toneMap(texture(scene, min(uv + vec2(texel.x, 0.0), uvMax)).rgb + bloomColor);
+        vec3 west = toneMap(texture(scene, max(uv - vec2(texel.x, 0.0), vec2(0.0))).rgb + bloomColor);
 
-    vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
+        vec3 minColor = min(result, min(min(north, south), min(east, west)));
+        vec3 maxColor = max(result, max(max(north, south), max(east, west)));
+        vec3 amplitude = sqrt(clamp(min(minColor, 1.0 - maxColor) / max(maxColor, vec3(1e-4)), 0.0, 1.0));
+        vec3 weight = amplitude * (-1.0 / mix(8.0, 5.0, sharpness));
+        result = clamp((result + (north + south + east + west) * weight) / (1.0 + 4.0 * weight), 0.0, 1.0);
+    }
 
-    FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+    FragColor = vec4(result, lumaInAlpha ? dot(result, vec3(0.299, 0.587, 0.114)) : 1.0);
+}
@@ -0,0 +1,136 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// tonemapovana slika, u alfa kanalu je njena osvetljenost (luma) iz zavrsnog prolaza
+uniform sampler2D screen;
+// parametri iz izabranog preseta (rg/Fxaa.h)
+uniform float edgeThreshold;
+uniform float edgeThresholdMin;
+uniform float subpixel;
+
+#ifndef FXAA_SEARCH_STEPS
+#define FXAA_SEARCH_STEPS 12
+#endif
+
+// duzine koraka pri trazenju krajeva ivice, sa manje koraka se brze odmice
+#if FXAA_SEARCH_STEPS <= 5
+const float SEARCH_STEP[5] = float[](1.0, 1.5, 2.0, 4.0, 12.0);
+#elif FXAA_SEARCH_STEPS <= 8
+const float SEARCH_STEP[8] = float[](1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0);
+#else
+const float SEARCH_STEP[12] = float[](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0);
+#endif
+const int SEARCH_STEPS = SEARCH_STEP.length();
+
+float lumaAt(vec2 uv)
+{
+    return textureLod(screen, uv, 0.0).a;
+}
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(screen, 0));
+    vec4 center = textureLod(screen, TexCoords, 0.0);
+
+    float lumaCenter = center.a;
+    float lumaN = textureLodOffset(screen, TexCoords, 0.0, ivec2(0, 1)).a;
+    float lumaS = textureLodOffset(screen, TexCoords, 0.0, ivec2(0, -1)).a;
+    float lumaE = textureLodOffset(screen, TexCoords, 0.0, ivec2(1, 0)).a;
+    float lumaW = textureLodOffset(screen, TexCoords, 0.0, ivec2(-1, 0)).a;
+
+    // bez dovoljnog kontrasta nema ivice, piksel ostaje kakav jeste
+    float lumaMin = min(lumaCenter, min(min(lumaN, lumaS), min(lumaE, lumaW)));
+    float lumaMax = max(lumaCenter, max(max(lumaN, lumaS), max(lumaE, lumaW)));
+    float lumaRange = lumaMax - lumaMin;
+    if (lumaRange < max(edgeThresholdMin, lumaMax * edgeThreshold)) {
+        FragColor = vec4(center.rgb, 1.0);
+        return;
+    }
+
+    float lumaNE = textureLodOffset(screen, TexCoords, 0.0, ivec2(1, 1)).a;
+    float lumaNW = textureLodOffset(screen, TexCoords, 0.0, ivec2(-1, 1)).a;
+    float lumaSE = textureLodOffset(screen, TexCoords, 0.0, ivec2(1, -1)).a;
+    float lumaSW = textureLodOffset(screen, TexCoords, 0.0, ivec2(-1, -1)).a;
+
+    // da li je ivica horizontalna ili vertikalna
+    float lumaNS = lumaN + lumaS;
+    float lumaEW = lumaE + lumaW;
+    float lumaNorthCorners = lumaNW + lumaNE;
+    float lumaSouthCorners = lumaSW + lumaSE;
+    float lumaEastCorners = lumaNE + lumaSE;
+    float lumaWestCorners = lumaNW + lumaSW;
+    float edgeHorizontal = abs(-2.0 * lumaW + lumaWestCorners) + 2.0 * abs(-2.0 * lumaCenter + lumaNS)
+                           + abs(-2.0 * lumaE + lumaEastCorners);
+    float edgeVertical = abs(-2.0 * lumaN + lumaNorthCorners) + 2.0 * abs(-2.0 * lumaCenter + lumaEW)
+                         + abs(-2.0 * lumaS + lumaSouthCorners);
+    bool horizontal = edgeHorizontal >= edgeVertical;
+
+    // na kojoj strani piksela je ivica
+    float luma1 = horizontal ? lumaS : lumaW;
+    float luma2 = horizontal ? lumaN : lumaE;
+    float gradient1 = luma1 - lumaCenter;
+    float gradient2 = luma2 - lumaCenter;
+    bool steepest1 = abs(gradient1) >= abs(gradient2);
+    float gradientScaled = 0.25 * max(abs(gradient1), abs(gradient2));
+
+    float stepLength = horizontal ? texel.y : texel.x;
+    float lumaLocalAverage;
+    if (steepest1) {
+        stepLength = -stepLength;
+        lumaLocalAverage = 0.5 * (luma1 + lumaCenter);
+    } else {
+        lumaLocalAverage = 0.5 * (luma2 + lumaCenter);
+    }
+
+    // trazimo krajeve ivice u oba smera, po sredini izmedju dva reda piksela
+    vec2 edgeUv = TexCoords;
+    if (horizontal)
+        edgeUv.y += stepLength * 0.5;
+    else
+        edgeUv.x += stepLength * 0.5;
+    vec2 offset = horizontal ? vec2(texel.x, 0.0) : vec2(0.0, texel.y);
+
+    vec2 uv1 = edgeUv - offset * SEARCH_STEP[0];
+    vec2 uv2 = edgeUv + offset * SEARCH_STEP[0];
+    float lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+    float lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+    bool reached1 = abs(lumaEnd1) >= gradientScaled;
+    bool reached2 = abs(lumaEnd2) >= gradientScaled;
+    for (int i = 1; i < SEARCH_STEPS && !(reached1 && reached2); ++i) {
+        if (!reached1) {
+            uv1 -= offset * SEARCH_STEP[i];
+            lumaEnd1 = lumaAt(uv1) - lumaLocalAverage;
+            reached1 = abs(lumaEnd1) >= gradientScaled;
+        }
+        if (!reached2) {
+            uv2 += offset * SEARCH_STEP[i];
+            lumaEnd2 = lumaAt(uv2) - lumaLocalAverage;
+            reached2 = abs(lumaEnd2) >= gradientScaled;
+        }
+    }
+
+    // pomeraj ka ivici zavisi od udaljenosti do blizeg kraja
+    float distance1 = horizontal ? TexCoords.x - uv1.x : TexCoords.y - uv1.y;
+    float distance2 = horizontal ? uv2.x - TexCoords.x : uv2.y - TexCoords.y;
+    bool closerTo1 = distance1 < distance2;
+    float pixelOffset = 0.5 - min(distance1, distance2) / (distance1 + distance2);
+    // samo ako se osvetljenost na blizem kraju menja u istom smeru kao u centru
+    bool centerSmaller = lumaCenter < lumaLocalAverage;
+    bool correctVariation = ((closerTo1 ? lumaEnd1 : lumaEnd2) < 0.0) != centerSmaller;
+    float finalOffset = correctVariation ? pixelOffset : 0.0;
+
+    // antialiasing ispod piksela, za tanke linije i usamljene piksele
+    float lumaAverage = (1.0 / 12.0) * (2.0 * (lumaNS + lumaEW) + lumaWestCorners + lumaEastCorners);
+    float subpixelBlend = clamp(abs(lumaAverage - lumaCenter) / lumaRange, 0.0, 1.0);
+    subpixelBlend = (-2.0 * subpixelBlend + 3.0) * subpixelBlend * subpixelBlend;
+    finalOffset = max(finalOffset, subpixelBlend * subpixelBlend * subpixel);
+
+    vec2 finalUv = TexCoords;
+    if (horizontal)
+        finalUv.y += finalOffset * stepLength;
+    else
+        finalUv.x += finalOffset * stepLength;
+    FragColor = vec4(textureLod(screen, finalUv, 0.0).rgb, 1.0);
+}
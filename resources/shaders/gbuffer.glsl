@@ -0,0 +1,28 @@
+// G-bafer za odlozeno osvetljenje:
+//   0: albedo.rgb, a = vrsta povrsine (0 specular iz albeda, 1 specular mapa)
+//   1: normala
+//   2: specularna boja
+// Dubina ostaje u dubinskoj teksturi G-bafera.
+
+#include "surface.glsl"
+
+#ifdef GBUFFER
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gNormal;
+layout (location = 2) out vec4 gSpecular;
+
+void writeGBuffer(Surface surface, vec3 normal)
+{
+    gAlbedo = vec4(surface.albedo, surface.spotAmbientCone);
+    gNormal = vec4(normal, 0.0);
+    gSpecular = vec4(surface.pointSpecular, 1.0);
+}
+#else
+// obrnuto od writeGBuffer; scena ima samo dve vrste povrsina, pa vrsta odredjuje ostale specularne boje
+Surface readGBuffer(vec4 albedo, vec4 specular)
+{
+    if (albedo.a < 0.5)
+        return Surface(albedo.rgb, vec3(1.0), specular.rgb, specular.rgb, 0.0);
+    return Surface(albedo.rgb, specular.rgb, specular.rgb, vec3(1.0), 1.0);
+}
+#endif
@@ -0,0 +1,212 @@
+// Zajednicko osvetljenje za base, cube i model shadere.
+// Tackasta svetla su podeljena po klasterima (vidi rg/LightClusters.h): fragment racuna
+// samo svetla iz svog klastera. Velicina mreze se zadaje pri prevodjenju.
+
+#include "surface.glsl"
+
+#ifndef CLUSTER_TILES_X
+#define CLUSTER_TILES_X 16
+#endif
+#ifndef CLUSTER_TILES_Y
+#define CLUSTER_TILES_Y 9
+#endif
+#ifndef CLUSTER_SLICES
+#define CLUSTER_SLICES 24
+#endif
+#ifndef SHADOW_CASCADES
+#define SHADOW_CASCADES 3
+#endif
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    // dalje od ovoga svetlo nema uticaja
+    float radius;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+
+    float cutOff;
+    float outerCutoff;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+uniform vec3 viewPos;
+uniform DirLight dirLight;
+uniform SpotLight spotLight;
+
+// po cetiri teksela za svako svetlo
+uniform samplerBuffer clusterLights;
+// indeksi svetala, redom po klasterima
+uniform usamplerBuffer clusterLightIndices;
+// za svaki klaster: prvi indeks i broj svetala
+uniform usamplerBuffer clusterRanges;
+// velicina jedne plocice u pikselima
+uniform vec2 clusterTileSize;
+// slice = log(dubina) * x + y
+uniform vec2 clusterDepthParams;
+// near i far ravan projekcije
+uniform vec2 clusterPlanes;
+
+// senke usmerenog svetla, jedan sloj po kaskadi (vidi rg/ShadowCascades.h)
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[SHADOW_CASCADES];
+// dubina na kojoj se kaskada zavrsava
+uniform float shadowSplits[SHADOW_CASCADES];
+// velicina jednog teksela kaskade u svetu
+uniform float shadowTexelSizes[SHADOW_CASCADES];
+// 0 iskljucuje senke
+uniform int shadowCascadeCount;
+uniform int shadowPcfRadius;
+
+PointLight fetchPointLight(int index)
+{
+    vec4 positionRadius = texelFetch(clusterLights, index * 4);
+    vec4 diffuseConstant = texelFetch(clusterLights, index * 4 + 1);
+    vec4 ambientLinear = texelFetch(clusterLights, index * 4 + 2);
+    vec4 specularQuadratic = texelFetch(clusterLights, index * 4 + 3);
+    return PointLight(positionRadius.xyz, positionRadius.w, ambientLinear.rgb, diffuseConstant.rgb,
+                      specularQuadratic.rgb, diffuseConstant.w, ambientLinear.w, specularQuadratic.w);
+}
+
+// linearna dubina iz dubinskog bafera
+float linearDepth(float windowDepth)
+{
+    float near = clusterPlanes.x;
+    float far = clusterPlanes.y;
+    float ndcDepth = windowDepth * 2.0 - 1.0;
+    return 2.0 * near * far / (far + near - ndcDepth * (far - near));
+}
+
+// fragCoord je kao gl_FragCoord.xy, viewDepth linearna dubina fragmenta koji se osvetljava
+int clusterIndex(vec2 fragCoord, float viewDepth)
+{
+    int slice = clamp(int(floor(log(viewDepth) * clusterDepthParams.x + clusterDepthParams.y)), 0, CLUSTER_SLICES - 1);
+    ivec2 tile = clamp(ivec2(fragCoord / clusterTileSize), ivec2(0), ivec2(CLUSTER_TILES_X - 1, CLUSTER_TILES_Y - 1));
+    return (slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x;
+}
+
+// 1.0 potpuno osvetljeno, 0.0 u senci
+float calcShadow(vec3 fragPos, vec3 normal, vec3 lightDir, float viewDepth)
+{
+    int cascade = 0;
+    while (cascade < shadowCascadeCount && viewDepth > shadowSplits[cascade])
+        cascade++;
+    if (cascade >= shadowCascadeCount)
+        return 1.0;
+
+    // pomeramo tacku duz normale, vise sto je povrsina kosija prema svetlu, da ne bi sama sebe zasenila
+    float slope = 1.0 - max(dot(normal, lightDir), 0.0);
+    vec3 offsetPos = fragPos + normal * shadowTexelSizes[cascade] * (1.0 + 2.0 * slope);
+    vec3 coords = (shadowMatrices[cascade] * vec4(offsetPos, 1.0)).xyz * 0.5 + 0.5;
+
+    // PCF: svaki uzorak je vec bilinearno filtrirano poredjenje
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -shadowPcfRadius; y <= shadowPcfRadius; ++y)
+        for (int x = -shadowPcfRadius; x <= shadowPcfRadius; ++x)
+            lit += texture(shadowMap, vec4(coords.xy + vec2(x, y) * texel, float(cascade), coords.z));
+    int side = 2 * shadowPcfRadius + 1;
+    return lit / float(side * side);
+}
+
+vec3 calcDirLight(DirLight light, Surface surface, vec3 normal, vec3 viewDir, float shadow)
+{
+    // smer padanja svetlosti
+    vec3 lightDir = normalize(-light.direction);
+    //difuzna komponenta
+    float diff = max(dot(normal, lightDir), 0.0);
+    //specularna, po blinu
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 16.0);
+
+    vec3 ambient = light.ambient * surface.albedo;
+    vec3 diffuse = light.diffuse * diff * surface.albedo;
+    vec3 specular = light.specular * spec * surface.dirSpecular;
+    return (ambient + (diffuse + specular) * shadow);
+}
+
+vec3 calcPointLight(PointLight light, Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+    //attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+    // svetlo se glatko gasi do radijusa, van njega ga klaster ne navodi
+    float falloff = clamp(1.0 - pow(distance / light.radius, 4.0), 0.0, 1.0);
+    attenuation *= falloff * falloff;
+
+    vec3 ambient = light.ambient * surface.albedo;
+    vec3 diffuse = light.diffuse * diff * surface.albedo;
+    vec3 specular = light.specular * spec * surface.pointSpecular;
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+vec3 calcSpotLight(SpotLight light, Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    //diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+    //specular
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+    //attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+
+    float epsilon = light.cutOff - light.outerCutoff;
+    float intensity = clamp((theta - light.outerCutoff)/epsilon, 0.0, 1.0);
+
+    vec3 ambient = light.ambient * surface.albedo;
+    vec3 diffuse = light.diffuse * diff * surface.albedo;
+    vec3 specular = light.specular * spec * surface.spotSpecular;
+
+    ambient *= attenuation * mix(1.0, intensity, surface.spotAmbientCone);
+    diffuse *= attenuation * intensity;
+    specular *= attenuation * intensity;
+
+    return (ambient + diffuse + specular);
+}
+
+// windowDepth je dubina fragmenta u [0, 1], u forward prolazu gl_FragCoord.z
+vec3 calcLighting(Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir, float windowDepth)
+{
+    float viewDepth = linearDepth(windowDepth);
+    float shadow = calcShadow(fragPos, normal, normalize(-dirLight.direction), viewDepth);
+    vec3 result = calcDirLight(dirLight, surface, normal, viewDir, shadow);
+    uvec2 range = texelFetch(clusterRanges, clusterIndex(gl_FragCoord.xy, viewDepth)).xy;
+    for (uint i = 0u; i < range.y; ++i) {
+        int lightIndex = int(texelFetch(clusterLightIndices, int(range.x + i)).x);
+        result += calcPointLight(fetchPointLight(lightIndex), surface, normal, fragPos, viewDir);
+    }
+    result += calcSpotLight(spotLight, surface, normal, fragPos, viewDir);
+    return result;
+}
@@ -0,0 +1,33 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// HDR slika scene
+uniform sampler2D scene;
+// popunjeni deo teksture scene
+uniform vec2 uvScale;
+
+// velicina cilja, AutoExposure::SIZE
+const float LUMINANCE_SIZE = 256.0;
+
+float logLuminance(vec2 uv)
+{
+    float luminance = dot(texture(scene, uv).rgb, vec3(0.2126, 0.7152, 0.0722));
+    // mali pomak, da crni pikseli ne daju -beskonacno
+    return log(max(luminance, 0.0) + 1e-4);
+}
+
+// Logaritam osvetljenosti; mipmape ga posle usrednje, pa je njihov poslednji nivo logaritam
+// geometrijske sredine, na koju jedan jak piksel manje utice nego na obicnu sredinu
+void main()
+{
+    vec2 uv = TexCoords * uvScale;
+    // jedan teksel pokriva vise piksela scene, zato cetiri uzorka umesto jednog
+    vec2 offset = uvScale * (0.25 / LUMINANCE_SIZE);
+    float result = logLuminance(uv + vec2(-offset.x, -offset.y));
+    result += logLuminance(uv + vec2(offset.x, -offset.y));
+    result += logLuminance(uv + vec2(-offset.x, offset.y));
+    result += logLuminance(uv + vec2(offset.x, offset.y));
+    FragColor = vec4(result * 0.25, 0.0, 0.0, 1.0);
+}
@@ -1,41 +1,15 @@
 #version 330 core
-layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
-struct DirLight {
-    vec3 direction;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
 
-    float constant;
-    float linear;
-    float quadratic;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-
-    float cutOff;
-    float outerCutoff;
+// GBUFFER varijanta samo upisuje povrsinu u G-bafer, osvetljenje dolazi kasnije (deferred.fs)
+#ifdef GBUFFER
+#include "gbuffer.glsl"
+#else
+layout (location = 0) out vec4 FragColor;
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+#include "lighting.glsl"
+#endif
 
-    float constant;
-    float linear;
-    float quadratic;
-};
+#include "motion_fragment.glsl"
 
 in VS_OUT {
     vec3 Normal;
@@ -43,103 +17,23 @@ in VS_OUT {
     vec3 FragPos;
 } fs_in;
 
-uniform vec3 viewPos;
-uniform int numOfPointLights;
-uniform SpotLight spotLight;
-uniform DirLight dirLight;
-uniform PointLight pointLights[3];
-
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
 
-
-
-vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-
-
 void main()
 {
-       vec3 normal = normalize(fs_in.Normal);
-       vec3 viewDir = normalize(viewPos - fs_in.FragPos);
-
-       vec3 result = calcDirLight(dirLight, normal, viewDir);
-       for(int i =  0; i < numOfPointLights; ++i) {
-            result+= calcPointLight(pointLights[i],normal,fs_in.FragPos,viewDir);
-       }
-       result += calcSpotLight(spotLight, normal, fs_in.FragPos, viewDir);
-
-       float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
-       if(brightness > 1.0)
-          BrightColor = vec4(result, 1.0);
-       else
-          BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
-
-        FragColor = vec4(result,1.0);
+    writeMotion(1.0);
+    vec3 diffuseColor = texture(texture_diffuse1, fs_in.TexCoord).rgb;
+    vec3 specularColor = texture(texture_specular1, fs_in.TexCoord).rgb;
+    Surface surface = Surface(diffuseColor, specularColor, specularColor, vec3(1.0), 1.0);
+    vec3 normal = normalize(fs_in.Normal);
+
+#ifdef GBUFFER
+    writeGBuffer(surface, normal);
+#else
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 result = calcLighting(surface, normal, fs_in.FragPos, viewDir, gl_FragCoord.z);
+
+    FragColor = vec4(result, 1.0);
+#endif
 }
-
-vec3 calcDirLight(DirLight light, vec3 normal, vec3 viewDir)
-{
-    vec3 lightDir = normalize(-light.direction);
-    //diffuse
-    float diff = max(dot(normal, lightDir), 0.0);
-    //specular
-    vec3 halfwayDir = normalize(lightDir + viewDir);
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), 16.0);
-
-    vec3 ambient = light.ambient * vec3(texture(texture_diffuse1, fs_in.TexCoord));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(texture_diffuse1, fs_in.TexCoord));
-    vec3 specular = light.specular * spec  * vec3(texture(texture_specular1, fs_in.TexCoord));
-    return (ambient + diffuse + specular);
-}
-
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-        //diffuse
-        float diff = max(dot(normal, lightDir), 0.0);
-        //specular
-        vec3 halfwayDir = normalize(lightDir + viewDir);
-        float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
-        //attenuation
-        float distance = length(light.position - fragPos);
-        float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
-
-        vec3 ambient = light.ambient * vec3(texture(texture_diffuse1, fs_in.TexCoord));
-        vec3 diffuse = light.diffuse * diff * vec3(texture(texture_diffuse1, fs_in.TexCoord));
-        vec3 specular = light.specular * spec * vec3(texture(texture_specular1, fs_in.TexCoord));
-
-        ambient *= attenuation;
-        diffuse *= attenuation;
-        specular *= attenuation;
-
-        return (ambient + diffuse + specular);
-}
-
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-    //diffuse
-    float diff = max(dot(normal, lightDir), 0.0);
-    //specular
-    vec3 halfwayDir = normalize(lightDir + viewDir);
-    float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
-    //attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
-
-    float theta = dot(lightDir, normalize(-light.direction));
-    float epsilon = light.cutOff - light.outerCutoff;
-    float intensity = clamp((theta - light.outerCutoff)/epsilon, 0.0, 1.0);
-
-    vec3 ambient = light.ambient * vec3(texture(texture_diffuse1, fs_in.TexCoord));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(texture_diffuse1, fs_in.TexCoord));
-    vec3 specular = light.specular * spec ;
-
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
-
-    return (ambient + diffuse + specular);
-}
\ No newline at end of file
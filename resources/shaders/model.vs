@@ -14,10 +14,13 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+#include "motion_vertex.glsl"
+
 void main()
 {
     vs_out.FragPos = vec3(model * vec4(aPos,1.0));
     vs_out.Normal = aNormal;
     vs_out.TexCoord = aTexCoords;
     gl_Position = projection * view * vec4(vs_out.FragPos,1.0);
+    writeMotion(vs_out.FragPos, aPos);
 }
\ No newline at end of file
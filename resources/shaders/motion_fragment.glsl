@@ -0,0 +1,18 @@
+// pomeraj fragmenta od prethodnog frejma, u UV koordinatama ekrana (vidi motion_vertex.glsl)
+
+in vec4 CurrentClip;
+in vec4 PreviousClip;
+
+#ifdef GBUFFER
+layout (location = 3) out vec4 Velocity;
+#else
+layout (location = 1) out vec4 Velocity;
+#endif
+
+// alpha odredjuje koliko se vektor mesa sa onim ispod, kod providnih objekata
+void writeMotion(float alpha)
+{
+    vec2 current = CurrentClip.xy / CurrentClip.w;
+    vec2 previous = PreviousClip.xy / PreviousClip.w;
+    Velocity = vec4((current - previous) * 0.5, 0.0, alpha);
+}
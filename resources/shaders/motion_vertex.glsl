@@ -0,0 +1,16 @@
+// Vektori kretanja za TAA: pozicija u klipu u ovom i u prethodnom frejmu, obe bez jitter-a.
+// Prepreke se pomeraju samo po z, pa je prethodna pozicija samo prethodna model matrica.
+
+// projection * view ovog frejma, bez jitter-a
+uniform mat4 motionViewProjection;
+uniform mat4 previousViewProjection;
+uniform mat4 previousModel;
+
+out vec4 CurrentClip;
+out vec4 PreviousClip;
+
+void writeMotion(vec3 worldPos, vec3 localPos)
+{
+    CurrentClip = motionViewProjection * vec4(worldPos, 1.0);
+    PreviousClip = previousViewProjection * previousModel * vec4(localPos, 1.0);
+}
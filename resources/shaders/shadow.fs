@@ -0,0 +1,6 @@
+#version 330 core
+
+// upisuje se samo dubina
+void main()
+{
+}
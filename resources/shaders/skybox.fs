@@ -1,7 +1,8 @@
 #version 330 core
 
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
+
+#include "motion_fragment.glsl"
 
 in vec3 TexCoords;
 
@@ -9,12 +10,7 @@ uniform samplerCube skybox;
 
 void main()
 {
-    vec3 result = texture(skybox, TexCoords).xyz;
-    FragColor = texture(skybox, TexCoords);
-    float brightness = dot(result.xyz, vec3(0.2126, 0.7152, 0.0722));
-    if(brightness > 1.0)
-       BrightColor = vec4(result, 1.0);
-    else
-       BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
-
-}
\ No newline at end of file
+    vec4 texColor = texture(skybox, TexCoords);
+    FragColor = texColor;
+    writeMotion(1.0);
+}
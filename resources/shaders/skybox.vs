@@ -6,9 +6,13 @@ out vec3 TexCoords;
 uniform mat4 projection;
 uniform mat4 view;
 
+// nebo je beskonacno daleko: matrice kretanja su bez translacije, kao view
+#include "motion_vertex.glsl"
+
 void main()
 {
     TexCoords = aPos;
     vec4 pos = projection * view * vec4(aPos, 1.0);
     gl_Position = pos.xyww;
+    writeMotion(aPos, aPos);
 }
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef SURFACE_GLSL
+#define SURFACE_GLSL
+
+// boje povrsine, teksture se citaju jednom u main-u pa se ovde samo prosledjuju
+struct Surface {
+    vec3 albedo;
+    // specularna boja za svaku vrstu svetla
+    vec3 dirSpecular;
+    vec3 pointSpecular;
+    vec3 spotSpecular;
+    // 1.0 ako i ambijentalna komponenta reflektora slabi van konusa
+    float spotAmbientCone;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#version 330 core
+out vec4 FragColor;
+
+// Temporalni antialiasing: trenutni frejm (u rezoluciji scene, sa jitter-om) se spaja sa istorijom
+// (u rezoluciji prozora) vracenom po vektorima kretanja. Istorija se ogranicava na boje iz okoline
+// trenutnog uzorka, da ne bi ostajali tragovi. Kada je scena manja od prozora, ovo je i uvecanje.
+
+in vec2 TexCoords;
+
+uniform sampler2D currentColor;
+uniform sampler2D velocity;
+uniform sampler2D history;
+// popunjeni deo currentColor i velocity
+uniform vec2 uvScale;
+// pomeraj slike ovog frejma u pikselima scene
+uniform vec2 jitter;
+// false posle promene velicine ili ukljucivanja, tada nema sta da se spaja
+uniform bool historyValid;
+// udeo novog uzorka kada pada tacno u centar piksela
+uniform float blendFactor;
+
+vec3 rgbToYCoCg(vec3 c)
+{
+    return vec3(0.25 * c.r + 0.5 * c.g + 0.25 * c.b, 0.5 * c.r - 0.5 * c.b, -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+vec3 yCoCgToRgb(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// HDR boje se mesaju kao da su tonemapirane, inace jedan jak piksel treperi kroz celu istoriju
+float toneWeight(vec3 c)
+{
+    return 1.0 / (1.0 + c.x);
+}
+
+// Catmull-Rom sa pet bilinearnih uzoraka, ostrija istorija od obicnog bilinearnog citanja
+vec3 sampleHistory(vec2 uv)
+{
+    vec2 size = vec2(textureSize(history, 0));
+    vec2 samplePos = uv * size;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+    vec2 texPos0 = (texPos1 - 1.0) / size;
+    vec2 texPos3 = (texPos1 + 2.0) / size;
+    vec2 texPos12 = (texPos1 + w2 / w12) / size;
+
+    vec3 result = texture(history, vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y;
+    result += texture(history, vec2(texPos0.x, texPos12.y)).rgb * w0.x * w12.y;
+    result += texture(history, texPos12).rgb * w12.x * w12.y;
+    result += texture(history, vec2(texPos3.x, texPos12.y)).rgb * w3.x * w12.y;
+    result += texture(history, vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    return max(result / weight, vec3(0.0));
+}
+
+void main()
+{
+    ivec2 sourceSize = ivec2(vec2(textureSize(currentColor, 0)) * uvScale + 0.5);
+    // piksel prozora u koordinatama scene; uzorak i pokriva tacku i + 0.5 - jitter
+    vec2 sourcePos = TexCoords * vec2(sourceSize);
+    ivec2 nearest = clamp(ivec2(floor(sourcePos + jitter)), ivec2(0), sourceSize - 1);
+    vec2 offset = sourcePos - (vec2(nearest) + 0.5 - jitter);
+
+    vec3 current = texelFetch(currentColor, nearest, 0).rgb;
+    if (!historyValid) {
+        // bez istorije je bilinearni uzorak bez jitter-a bolji od najblizeg
+        FragColor = vec4(texture(currentColor, (sourcePos + jitter) / vec2(textureSize(currentColor, 0))).rgb, 1.0);
+        return;
+    }
+
+    // okolina trenutnog uzorka odredjuje dozvoljen opseg istorije
+    vec3 minColor = vec3(1e9);
+    vec3 maxColor = vec3(-1e9);
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            ivec2 texel = clamp(nearest + ivec2(x, y), ivec2(0), sourceSize - 1);
+            vec3 color = rgbToYCoCg(texelFetch(currentColor, texel, 0).rgb);
+            minColor = min(minColor, color);
+            maxColor = max(maxColor, color);
+        }
+    }
+
+    vec2 motion = texelFetch(velocity, nearest, 0).xy;
+    vec2 historyUv = TexCoords - motion;
+    vec3 currentYCoCg = rgbToYCoCg(current);
+    vec3 historyYCoCg = clamp(rgbToYCoCg(sampleHistory(historyUv)), minColor, maxColor);
+
+    // uzorak blizu centra piksela vredi vise; van ekrana istorije nema
+    float alpha = blendFactor * exp(-2.29 * dot(offset, offset));
+    alpha = max(alpha, 0.02);
+    if (any(lessThan(historyUv, vec2(0.0))) || any(greaterThan(historyUv, vec2(1.0))))
+        alpha = 1.0;
+
+    float currentWeight = alpha * toneWeight(currentYCoCg);
+    float historyWeight = (1.0 - alpha) * toneWeight(historyYCoCg);
+    vec3 result = (currentYCoCg * currentWeight + historyYCoCg * historyWeight) / (currentWeight + historyWeight);
+    FragColor = vec4(yCoCgToRgb(result), 1.0);
+}
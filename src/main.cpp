@@ -1,3 +1,6 @@
+// zamena operator new/delete koja broji alokacije, samo uz -DRG_ALLOCATION_TRACKING=ON
+#define RG_ALLOCATION_HOOKS
+#include "rg/AllocationTracker.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
@@ -8,6 +11,28 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include "rg/Cube.h"
+#include "rg/Benchmark.h"
+#include "rg/DynamicResolution.h"
+#include "rg/GLExtensions.h"
+#include "rg/Frustum.h"
+#include "rg/LightClusters.h"
+#include "rg/GLState.h"
+#include "rg/GpuTimer.h"
+#include "rg/RenderQueue.h"
+#include "rg/RenderTarget.h"
+#include "rg/ShaderLibrary.h"
+#include "rg/ShadowCascades.h"
+#include "rg/TemporalAA.h"
+#include "rg/Fxaa.h"
+#include "rg/RenderGraph.h"
+#include "rg/AutoExposure.h"
+#include "rg/FrameCapture.h"
+#include "rg/GLDebug.h"
+#include "rg/FrameArena.h"
+#include "rg/FrameStats.h"
+#include "rg/Profiler.h"
+#include "rg/HitchDetector.h"
+#include "rg/StartupTimeline.h"
 
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
@@ -21,7 +46,10 @@
 
 
 #include <vector>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <limits>
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
@@ -41,13 +69,18 @@ void renderQuad();
 
 unsigned int loadCubemap(std::vector<std::string> faces);
 
-void setUpShaderLights(Shader shader);
+void setUpShaderLights(const Shader &shader, const rg::LightClusters &lightClusters,
+                       const rg::ShadowCascades &shadowCascades);
 
 unsigned int loadTexture(char const* path, bool gammaCorrection);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+// boja svetla koje daju poeni
+const glm::vec3 PICKUP_LIGHT_COLOR(1.0f, 0.75f, 0.3f);
 
 // camera
 Camera camera(glm::vec3(0.0f, 1.0f, 3.0f));
@@ -108,7 +141,27 @@ struct ProgramState {
     int numOfPointLights = 3;
 
     bool bloom = true;
+    // boja scene u R11F_G11F_B10F umesto RGBA16F, upola manje memorije i saobracaja
+    bool compactHdr = true;
+    // bloom se racuna u 1/1, 1/2 ili 1/4 rezolucije scene po osi
+    int bloomDownsample = 2;
     bool bloomKeyPressed = false;
+    // poeni svetle i osvetljavaju okolinu
+    bool pickupLights = true;
+    // osvetljenje iz G-bafera umesto u svakom shaderu
+    bool deferred = false;
+    // senke usmerenog svetla
+    rg::ShadowSettings shadows;
+    // rezolucija scene se prilagodjava GPU vremenu
+    rg::DynamicResolutionSettings resolution;
+    // temporalni antialiasing, ujedno i uvecanje scene do velicine prozora
+    bool taa = true;
+    // FXAA posle tonemapiranja, rg::FxaaQuality
+    int fxaa = rg::FXAA_OFF;
+    // ekspozicija po prosecnoj osvetljenosti scene; kad je iskljucena, vazi rucna vrednost exposure
+    rg::AutoExposureSettings autoExposure;
+    // frejmovi mnogo sporiji od medijane se beleze u hitches.log
+    rg::HitchSettings hitches;
     float exposure = 1.0f;
     float cubesSpeed = 1.5f;
     int score = 0;
@@ -269,17 +322,132 @@ void ProgramState::setUpLights() {
 
 
 ProgramState* programState;
-std::vector<Cube*> cubes;
+// po vrednosti: kocke se ne alociraju pojedinacno, kapacitet se zadrzava izmedju frejmova
+std::vector<Cube> cubes;
+
+/* Objekti koje scena prijavljuje redu za iscrtavanje */
+enum SceneObject {
+    OBJECT_GROUND,
+    OBJECT_CUBE,
+    OBJECT_VEGETATION,
+    OBJECT_PANDA,
+    OBJECT_SKYBOX
+};
+
+/* Shaderi scene */
+struct SceneShaders {
+    Shader *base;
+    Shader *cube;
+    // kocke-poeni, samo emisivna boja
+    Shader *point;
+    Shader *blend;
+    Shader *model;
+    Shader *skybox;
+    // odlozeno osvetljenje: upis u G-bafer i prolaz osvetljenja preko celog ekrana
+    Shader *gbufferBase;
+    Shader *gbufferCube;
+    Shader *gbufferModel;
+    Shader *deferredLighting;
+};
+
+struct SceneDraw {
+    SceneObject object;
+    glm::mat4 model;
+    bool isPoint;
+    // model matrica u prethodnom frejmu, za vektore kretanja
+    glm::mat4 previousModel;
+};
 
 
 float xPandaPosition = 0.0f;
 
 bool isGameOver = false;
 
+// broj objekata odsecenih u poslednjem frejmu
+unsigned int culledObjects = 0;
+// svetla i ukupna duzina lista po klasterima u poslednjem frejmu
+unsigned int clusteredLightCount = 0;
+unsigned int clusteredLightEntries = 0;
+// GPU vreme iscrtavanja scene u poslednjem izmerenom frejmu
+double sceneGpuMilliseconds = 0.0;
+unsigned int shadowDraws = 0;
+// rezolucija u kojoj je scena iscrtana u poslednjem frejmu
+float sceneRenderScale = 1.0f;
+glm::ivec2 sceneRenderSize(SCR_WIDTH, SCR_HEIGHT);
+// GPU vreme celog frejma (scena i obrada posle nje) po kome se bira rezolucija
+double frameGpuMilliseconds = 0.0;
+unsigned int shadowStaticRefreshes = 0;
+// prolazi grafa frejma i memorija privremenih tekstura u poslednjem frejmu
+unsigned int renderGraphPasses = 0;
+unsigned int renderGraphCulledPasses = 0;
+size_t renderGraphTransientBytes = 0;
+size_t renderGraphUnaliasedBytes = 0;
+// ispis grafa na stdout posle sledeceg frejma
+bool dumpRenderGraph = false;
+// memorija HDR i bloom ciljeva i procena bajtova koje frejm kroz njih prenese, uz iste
+// vrednosti za pocetni raspored (RGBA16F, bright MRT i bloom u punoj rezoluciji)
+size_t hdrTargetBytes = 0;
+size_t hdrTargetBaselineBytes = 0;
+size_t hdrTrafficBytes = 0;
+size_t hdrTrafficBaselineBytes = 0;
+// geometrijska sredina osvetljenosti scene i ekspozicija sa kojom je frejm tonemapiran
+float sceneAverageLuminance = 1.0f;
+float frameExposure = 1.0f;
+// F9 ukljucuje i iskljucuje snimanje; stanje snimka za prikaz
+bool captureToggleRequested = false;
+bool captureRecording = false;
+unsigned int captureFrames = 0;
+unsigned int captureDroppedFrames = 0;
+// zastoji zabelezeni od pokretanja i medijana vremena frejma sa kojom se porede
+unsigned int hitchCount = 0;
+double hitchMedianMilliseconds = 0.0;
+
+
+int main(int argc, char **argv) {
+    // vreme pokretanja se meri od ovog poziva
+    rg::startupTimeline();
+    /* --benchmark [frejmova po rezimu]: poredi forward i deferred osvetljenje pa izlazi */
+    /* --capture <putanja>: snima od prvog frejma; .y4m je jedan video fajl, inace niz PPM slika */
+    /* --first-frame: prikazuje jedan frejm, ispisuje faze pokretanja i izlazi */
+    /* --startup-benchmark [parova]: naizmenicno hladna i topla pokretanja sa --first-frame */
+    /* --alloc-check [frejmova]: posle zagrevanja nijedan frejm ne sme da alocira na heap-u */
+    rg::Benchmark benchmark;
+    unsigned int benchmarkFrames = 0;
+    rg::AllocationCheck allocationCheck;
+    unsigned int allocationCheckFrames = 0;
+    unsigned int startupBenchmarkRuns = 0;
+    bool firstFrameOnly = false;
+    std::string capturePath;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--benchmark") == 0)
+            benchmarkFrames = (i + 1 < argc && std::atoi(argv[i + 1]) > 0) ? std::atoi(argv[++i]) : 600;
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (std::strcmp(argv[i], "--first-frame") == 0)
+            firstFrameOnly = true;
+        else if (std::strcmp(argv[i], "--startup-benchmark") == 0)
+            startupBenchmarkRuns = (i + 1 < argc && std::atoi(argv[i + 1]) > 0) ? std::atoi(argv[++i]) : 5;
+        else if (std::strcmp(argv[i], "--alloc-check") == 0)
+            allocationCheckFrames = (i + 1 < argc && std::atoi(argv[i + 1]) > 0) ? std::atoi(argv[++i]) : 600;
+    }
+    if (allocationCheckFrames > 0 && !RG_ALLOCATION_TRACKING) {
+        std::cout << "--alloc-check needs a build with -DRG_ALLOCATION_TRACKING=ON" << std::endl;
+        return -1;
+    }
+    if (startupBenchmarkRuns > 0) {
+        // hladno pokretanje cita igru, biblioteke i kes shadera sa diska
+        rg::StartupBenchmark startupBenchmark(std::string("'") + argv[0] + "' --first-frame",
+                                              {argv[0], "resources", "shader_cache"});
+        bool completed = startupBenchmark.run(startupBenchmarkRuns);
+        startupBenchmark.report(std::cout);
+        if (!completed)
+            std::cout << "Startup benchmark: a run failed" << std::endl;
+        return completed ? 0 : -1;
+    }
 
-int main() {
     // glfw: initialize and configure
     // ------------------------------
+    int windowPhase = rg::startupTimeline().begin("window");
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -288,6 +456,10 @@ int main() {
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+#if RG_GL_CHECKS == RG_GL_CHECKS_SYNC
+    // sinhrone poruke o greskama pouzdano stizu samo iz debug konteksta
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
 
     // glfw window creation
     // --------------------
@@ -300,22 +472,34 @@ int main() {
     glfwMakeContextCurrent(window);
     glfwSetKeyCallback(window, key_callback);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    rg::startupTimeline().end(windowPhase);
     // glad: load all OpenGL function pointers
     // ---------------------------------------
+    int gladPhase = rg::startupTimeline().begin("GLAD");
     if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    rg::loadGLExtensions((GLADloadproc) glfwGetProcAddress);
+    // greske i upozorenja drajvera stizu kroz KHR_debug callback, bez glGetError posle svakog poziva
+    rg::enableDebugOutput(GL_DEBUG_SEVERITY_MEDIUM);
+    rg::startupTimeline().end(gladPhase);
+    // merimo koliko renderer moze, ne vsync
+    if (benchmarkFrames > 0 || firstFrameOnly || allocationCheckFrames > 0)
+        glfwSwapInterval(0);
 
 
 
+    int statePhase = rg::startupTimeline().begin("program state");
     programState = new ProgramState();
     programState->setUpLights();
     programState ->LoadFromFile("resources/program_state.txt");
     if (programState->ImguiEnabled) {
         glfwSetInputMode(window,GLFW_CURSOR, GLFW_CURSOR_NORMAL);
     }
+    rg::startupTimeline().end(statePhase);
 
+    int imguiPhase = rg::startupTimeline().begin("ImGui");
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO &io = ImGui::GetIO();
@@ -323,537 +507,1214 @@ int main() {
 
     ImGui_ImplGlfw_InitForOpenGL(window,true);
     ImGui_ImplOpenGL3_Init("#version 330 core");
+    rg::startupTimeline().end(imguiPhase);
 
-    /*Shaderi */
-
-    Shader baseShader("resources/shaders/base.vs", "resources/shaders/base.fs");
-    Shader cubeShader ("resources/shaders/cube.vs","resources/shaders/cube.fs");
-    Shader blendShader ("resources/shaders/blending.vs","resources/shaders/blending.fs");
-    Shader modelShader ("resources/shaders/model.vs","resources/shaders/model.fs");
-    Shader skyboxShader("resources/shaders/skybox.vs","resources/shaders/skybox.fs");
-    Shader blurShader("resources/shaders/blur.vs","resources/shaders/blur.fs");
-    Shader finalShader ("resources/shaders/final.vs","resources/shaders/final.fs");
-
-
-    // configure (floating point) framebuffers
-    // ---------------------------------------
-    unsigned int hdrFBO;
-    glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-    // create 2 floating point color buffers (1 for normal rendering, other for brightness threshold values)
-    unsigned int colorBuffers[2];
-    glGenTextures(2, colorBuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCR_WIDTH, SCR_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
-    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-    glDrawBuffers(2, attachments);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // ping-pong-framebufer
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (unsigned int i = 0; i < 2; i++)
+    /* Sve sto drzi GL objekte zivi u ovom bloku: destruktori ih brisu dok kontekst jos postoji,
+       pre glfwTerminate */
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
-    }
-
-
-    /*Modeli*/
-
-    Model pandaModel("resources/objects/panda/scene.gltf");
-
-    float planeVertices[] = {
-            //positions - 3f                   //normals - 3f                      //texture coords - 2f
-            1.0f,  0.0f, 1.0f, 0.0f, 1.0f, 0.0f,       1.0f, 0.0f,
-            1.0f,  0.0f, -1.0f, 0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
-            -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,0.0f, 1.0f,
-            -1.0f, 0.0f,1.0f, 0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
-    };
-
-    unsigned int planeIndices[] = {
-            0, 1, 3,
-            1, 2, 3
-    };
-
-
-    glEnable(GL_DEPTH_TEST);
-
-    float cubeVertices[] = {
-            //back face
-            // positions                       // normals                         // texture coords
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
-            0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
-
-            //front face
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-            0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
-
-            //left face
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-            -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-            -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-
-            //right face
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-            0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-            0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
-            0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
-            0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
-
-            //bottom face
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-            0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
-            0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
-            -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
-            -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
-
-            //top face
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
-            0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-            0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
-            -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
-            -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
-    };
-
-
-    float transparentVertices[] = {
-            // positions         // texture Coords (swapped y coordinates because texture is flipped upside down)
-            0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
-            0.0f, -0.5f,  0.0f,  0.0f,  1.0f,
-            1.0f, -0.5f,  0.0f,  1.0f,  1.0f,
-
-            0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
-            1.0f, -0.5f,  0.0f,  1.0f,  1.0f,
-            1.0f,  0.5f,  0.0f,  1.0f,  0.0f
-    };
-
-    float skyboxVertices[] = {
-            // positions
-            -1.0f,  1.0f, -1.0f,
-            -1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-            -1.0f,  1.0f, -1.0f,
-            1.0f,  1.0f, -1.0f,
-            1.0f,  1.0f,  1.0f,
-            1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-            1.0f, -1.0f, -1.0f,
-            1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-            1.0f, -1.0f,  1.0f
-    };
-
-    /*Saljemo podatke o vertexima na graficku */
-    unsigned int planeVAO, planeVBO, planeEBO;
-
-    glGenVertexArrays(1, &planeVAO);
-    glGenBuffers(1, &planeVBO);
-    glGenBuffers(1, &planeEBO);
-
-    glBindVertexArray(planeVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(planeIndices), planeIndices, GL_STATIC_DRAW);
-
-    /* Znacenje atributa */
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3*sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6*sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    /* Deakiviramo bafer */
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    unsigned int cubeVBO, cubeVAO;
-
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-
-    glBindVertexArray(cubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData (GL_ARRAY_BUFFER, sizeof(cubeVertices),cubeVertices,GL_STATIC_DRAW);
-
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3*sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6*sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-
-    unsigned int transparentVAO, transparentVBO;
-    glGenVertexArrays(1, &transparentVAO);
-    glGenBuffers(1, &transparentVBO);
-    glBindVertexArray(transparentVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, transparentVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(transparentVertices), transparentVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glBindVertexArray(0);
+        /*Shaderi */
+
+        /* Svaka varijanta se prevodi jednom, broj svetala je ugradjen u shader */
+        double shaderStart = glfwGetTime();
+        int shadersPhase = rg::startupTimeline().begin("shaders");
+        rg::ProgramBinaryCache programCache("shader_cache");
+        rg::ShaderLibrary shaderLibrary(&programCache);
+        std::vector<std::string> defines = rg::LightClusters::shaderDefines();
+        for (const std::string &define : rg::ShadowCascades::shaderDefines())
+            defines.push_back(define);
+        std::vector<std::string> emissiveDefines = defines;
+        emissiveDefines.push_back("EMISSIVE");
+        std::vector<std::string> gbufferDefines = rg::LightClusters::shaderDefines();
+        gbufferDefines.push_back("GBUFFER");
+
+        SceneShaders sceneShaders;
+        sceneShaders.base = &shaderLibrary.request("resources/shaders/base.vs", "resources/shaders/base.fs", defines);
+        sceneShaders.cube = &shaderLibrary.request("resources/shaders/cube.vs", "resources/shaders/cube.fs", defines);
+        sceneShaders.point = &shaderLibrary.request("resources/shaders/cube.vs", "resources/shaders/cube.fs", emissiveDefines);
+        sceneShaders.blend = &shaderLibrary.request("resources/shaders/blending.vs", "resources/shaders/blending.fs", defines);
+        sceneShaders.model = &shaderLibrary.request("resources/shaders/model.vs", "resources/shaders/model.fs", defines);
+        sceneShaders.skybox = &shaderLibrary.request("resources/shaders/skybox.vs", "resources/shaders/skybox.fs", defines);
+        sceneShaders.gbufferBase = &shaderLibrary.request("resources/shaders/base.vs", "resources/shaders/base.fs", gbufferDefines);
+        sceneShaders.gbufferCube = &shaderLibrary.request("resources/shaders/cube.vs", "resources/shaders/cube.fs", gbufferDefines);
+        sceneShaders.gbufferModel = &shaderLibrary.request("resources/shaders/model.vs", "resources/shaders/model.fs", gbufferDefines);
+        sceneShaders.deferredLighting = &shaderLibrary.request("resources/shaders/final.vs", "resources/shaders/deferred.fs", defines);
+        Shader &brightShader = shaderLibrary.request("resources/shaders/final.vs", "resources/shaders/bright.fs");
+        Shader &blurShader = shaderLibrary.request("resources/shaders/blur.vs", "resources/shaders/blur.fs");
+        Shader &finalShader = shaderLibrary.request("resources/shaders/final.vs", "resources/shaders/final.fs");
+        Shader &shadowShader = shaderLibrary.request("resources/shaders/shadow.vs", "resources/shaders/shadow.fs");
+        Shader &taaShader = shaderLibrary.request("resources/shaders/final.vs", "resources/shaders/taa.fs");
+        Shader &luminanceShader = shaderLibrary.request("resources/shaders/final.vs", "resources/shaders/luminance.fs");
+        // po jedan program za svaki preset, razlikuju se u broju koraka pretrage
+        Shader *fxaaShaders[rg::FXAA_QUALITY_COUNT] = {};
+        for (int quality = rg::FXAA_LOW; quality < rg::FXAA_QUALITY_COUNT; ++quality)
+            fxaaShaders[quality] = &shaderLibrary.request("resources/shaders/final.vs", "resources/shaders/fxaa.fs",
+                                                          rg::Fxaa::shaderDefines((rg::FxaaQuality) quality));
+        // svi programi su poslati drajveru, tek sada cekamo rezultat
+        int compilePhase = rg::startupTimeline().begin("wait for the driver");
+        shaderLibrary.finish();
+        rg::startupTimeline().end(compilePhase);
+        rg::startupTimeline().end(shadersPhase);
+        std::cout << "Shaders: " << shaderLibrary.size() << " programs, " << programCache.hits()
+                  << " loaded from the binary cache, " << glfwGetTime() - shaderStart << "s" << std::endl;
+        int targetsPhase = rg::startupTimeline().begin("render targets");
+        /* Tackasta svetla rasporedjena po klasterima frustuma */
+        rg::LightClusters lightClusters;
+        /* Kaskade senki, staticni deo se cuva dok se kaskada ne pomeri */
+        rg::ShadowCascades shadowCascades;
+
+        SceneShaders *shaders = &sceneShaders;
+
+
+        /* Ciljevi iscrtavanja su velicine prozora i prate njegovu promenu, scena se crta u njihov
+           donji levi deo, onoliki koliko dozvoljava dinamicka rezolucija */
+        // HDR boja scene; svetli delovi za bloom se izdvajaju posle, u manjoj rezoluciji
+        rg::RenderTarget hdrTarget("hdr", {{(GLenum) (programState->compactHdr ? GL_R11F_G11F_B10F : GL_RGBA16F), GL_LINEAR}},
+                                   rg::DEPTH_RENDERBUFFER);
+        // vektori kretanja za TAA; pisu ih i forward i G-bafer prolaz, zato je zakacen i na G-bafer
+        rg::RenderTarget velocityTarget("velocity", {{GL_RG16F, GL_NEAREST}}, rg::DEPTH_NONE);
+        hdrTarget.shareColor(velocityTarget.colorTexture(0));
+        // istorija TAA, u rezoluciji prozora
+        rg::TemporalAA temporalAA;
+        // osvetljenost scene za automatsku ekspoziciju, cita se nekoliko frejmova kasnije
+        rg::AutoExposure autoExposure;
+        /* G-bafer, bloom ping-pong i LDR slika za FXAA su privremene teksture grafa frejma:
+           postoje samo dok ih neki prolaz koristi i dele memoriju kad im se zivoti ne preklapaju */
+        rg::RenderGraph renderGraph;
+
+        auto resizeRenderTargets = [&](int width, int height) {
+            if (width == hdrTarget.width() && height == hdrTarget.height())
+                return;
+            velocityTarget.resize(width, height);
+            hdrTarget.resize(width, height);
+            temporalAA.resize(width, height);
+            rg::glState().invalidate();
+        };
+        {
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            resizeRenderTargets(std::max(width, 1), std::max(height, 1));
+        }
 
-    unsigned int skyboxVAO, skyboxVBO;
-    glGenVertexArrays(1, &skyboxVAO);
-    glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        // imena se pri promeni velicine ne menjaju
+        unsigned int hdrFBO = hdrTarget.framebuffer();
+        unsigned int colorBuffer = hdrTarget.colorTexture(0);
+        unsigned int velocityBuffer = velocityTarget.colorTexture(0);
+        rg::startupTimeline().end(targetsPhase);
 
-    std::vector<std::string> faces
-            {
-                    "resources/textures/skybox/right.jpg",
-                    "resources/textures/skybox/left.jpg",
-                   "resources/textures/skybox/top.jpg",
-                    "resources/textures/skybox/bottom.jpg",
-                    "resources/textures/skybox/front.jpg",
-                    "resources/textures/skybox/back.jpg"
-            };
 
-    /* Generisanje teksture */
+        /*Modeli*/
 
+        int modelPhase = rg::startupTimeline().begin("model resources/objects/panda/scene.gltf");
+        Model pandaModel("resources/objects/panda/scene.gltf");
+        // geometry is on the GPU now, only counts and bounds are needed on the CPU side
+        pandaModel.ReleaseGeometry();
+        rg::startupTimeline().end(modelPhase);
 
+        float planeVertices[] = {
+                //positions - 3f                   //normals - 3f                      //texture coords - 2f
+                1.0f,  0.0f, 1.0f, 0.0f, 1.0f, 0.0f,       1.0f, 0.0f,
+                1.0f,  0.0f, -1.0f, 0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
+                -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,0.0f, 1.0f,
+                -1.0f, 0.0f,1.0f, 0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+        };
 
-    unsigned int planeTexture = loadTexture("resources/textures/grass2.jpg",true);
-    unsigned int cubeTexture = loadTexture("resources/textures/brick.jpg",false);
-    unsigned int vegetationTexture = loadTexture("resources/textures/grass.png",false);
-    unsigned int cubemapTexture = loadCubemap(faces);
+        unsigned int planeIndices[] = {
+                0, 1, 3,
+                1, 2, 3
+        };
 
 
+        glEnable(GL_DEPTH_TEST);
+
+        float cubeVertices[] = {
+                //back face
+                // positions                       // normals                         // texture coords
+                -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+                0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+                0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+                0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+                -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+                -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+                //front face
+                -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+                0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+                0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+                0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+                -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+                -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+
+                //left face
+                -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+                -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+                -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+                -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+                -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+                -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+
+                //right face
+                0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+                0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+                0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+                0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+                0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+                0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+                //bottom face
+                -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+                0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+                0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+                0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+                -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+                -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+
+                //top face
+                -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+                0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+                0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+                0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+                -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+                -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+        };
 
 
-    /* Pravimo kolekciju prepreka i poena*/
+        float transparentVertices[] = {
+                // positions         // texture Coords (swapped y coordinates because texture is flipped upside down)
+                0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
+                0.0f, -0.5f,  0.0f,  0.0f,  1.0f,
+                1.0f, -0.5f,  0.0f,  1.0f,  1.0f,
 
-    Cube* initialBrick = new Cube(false);
-    Cube* initialPoint = new Cube(initialBrick->getXCoord(), true);
-    cubes.push_back(initialBrick);
-    cubes.push_back(initialPoint);
+                0.0f,  0.5f,  0.0f,  0.0f,  0.0f,
+                1.0f, -0.5f,  0.0f,  1.0f,  1.0f,
+                1.0f,  0.5f,  0.0f,  1.0f,  0.0f
+        };
 
-    skyboxShader.use();
-    skyboxShader.setInt("skybox", 0);
-    blurShader.use();
-    blurShader.setInt("image", 0);
-    finalShader.use();
-    finalShader.setInt("scene", 0);
-    finalShader.setInt("bloomBlur", 1);
+        float skyboxVertices[] = {
+                // positions
+                -1.0f,  1.0f, -1.0f,
+                -1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+                1.0f,  1.0f, -1.0f,
+                -1.0f,  1.0f, -1.0f,
+
+                -1.0f, -1.0f,  1.0f,
+                -1.0f, -1.0f, -1.0f,
+                -1.0f,  1.0f, -1.0f,
+                -1.0f,  1.0f, -1.0f,
+                -1.0f,  1.0f,  1.0f,
+                -1.0f, -1.0f,  1.0f,
+
+                1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+
+                -1.0f, -1.0f,  1.0f,
+                -1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f, -1.0f,  1.0f,
+                -1.0f, -1.0f,  1.0f,
+
+                -1.0f,  1.0f, -1.0f,
+                1.0f,  1.0f, -1.0f,
+                1.0f,  1.0f,  1.0f,
+                1.0f,  1.0f,  1.0f,
+                -1.0f,  1.0f,  1.0f,
+                -1.0f,  1.0f, -1.0f,
+
+                -1.0f, -1.0f, -1.0f,
+                -1.0f, -1.0f,  1.0f,
+                1.0f, -1.0f, -1.0f,
+                1.0f, -1.0f, -1.0f,
+                -1.0f, -1.0f,  1.0f,
+                1.0f, -1.0f,  1.0f
+        };
 
+        /*Saljemo podatke o vertexima na graficku */
+        unsigned int planeVAO, planeVBO, planeEBO;
 
-       // render loop
-    // -----------
-    while (!glfwWindowShouldClose(window)) {
-        // per-frame time logic
-        // --------------------
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        glGenVertexArrays(1, &planeVAO);
+        glGenBuffers(1, &planeVBO);
+        glGenBuffers(1, &planeEBO);
 
-        // input
-        // -----
-        processInput(window);
+        glBindVertexArray(planeVAO);
 
-        // render
-        // ------
-        glClearColor(0.0f, 0.7f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
+        rg::bufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
 
-        /* 1.RENDER U FB*/
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeEBO);
+        rg::bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(planeIndices), planeIndices, GL_STATIC_DRAW);
 
-        baseShader.use();
-        baseShader.setInt("planeTexture", 0);
+        /* Znacenje atributa */
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, planeTexture);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3*sizeof(float)));
+        glEnableVertexAttribArray(1);
 
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH/(float)SCR_HEIGHT, 0.1f, 100.0f);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6*sizeof(float)));
+        glEnableVertexAttribArray(2);
 
-        baseShader.setMat4("projection", projection);
-        baseShader.setMat4("view", view);
-        setUpShaderLights(baseShader);
+        /* Deakiviramo bafer */
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
 
-        glBindVertexArray(planeVAO);
-        for(unsigned int i = 0; i< 10; i++){
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, glm::vec3(0.0f,0.0f,-2.0f * i));
-            baseShader.setMat4("model", model);
-            glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        }
+        unsigned int cubeVBO, cubeVAO;
 
+        glGenVertexArrays(1, &cubeVAO);
+        glGenBuffers(1, &cubeVBO);
 
         glBindVertexArray(cubeVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        rg::bufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices),cubeVertices,GL_STATIC_DRAW);
 
-        cubeShader.use();
-        cubeShader.setMat4("projection", projection);
-        cubeShader.setMat4("view", view);
-        cubeShader.setInt("cubeTexture", 0);
 
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3*sizeof(float)));
+        glEnableVertexAttribArray(1);
 
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6*sizeof(float)));
+        glEnableVertexAttribArray(2);
 
-        setUpShaderLights(cubeShader);
 
+        unsigned int transparentVAO, transparentVBO;
+        glGenVertexArrays(1, &transparentVAO);
+        glGenBuffers(1, &transparentVBO);
+        glBindVertexArray(transparentVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, transparentVBO);
+        rg::bufferData(GL_ARRAY_BUFFER, sizeof(transparentVertices), transparentVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+        glBindVertexArray(0);
 
-        glEnable(GL_CULL_FACE);
-        glFrontFace(GL_CW);
+        unsigned int skyboxVAO, skyboxVBO;
+        glGenVertexArrays(1, &skyboxVAO);
+        glGenBuffers(1, &skyboxVBO);
+        glBindVertexArray(skyboxVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
+        rg::bufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+
+        std::vector<std::string> faces
+                {
+                        "resources/textures/skybox/right.jpg",
+                        "resources/textures/skybox/left.jpg",
+                       "resources/textures/skybox/top.jpg",
+                        "resources/textures/skybox/bottom.jpg",
+                        "resources/textures/skybox/front.jpg",
+                        "resources/textures/skybox/back.jpg"
+                };
+
+        /* Generisanje teksture */
+
+
+
+        unsigned int planeTexture = loadTexture("resources/textures/grass2.jpg",true);
+        unsigned int cubeTexture = loadTexture("resources/textures/brick.jpg",false);
+        unsigned int vegetationTexture = loadTexture("resources/textures/grass.png",false);
+        unsigned int cubemapTexture = loadCubemap(faces);
+
+
+
+
+        /* Pravimo kolekciju prepreka i poena*/
+
+        cubes.reserve(64);
+        cubes.push_back(Cube(false));
+        cubes.push_back(Cube(cubes.back().getXCoord(), true));
+
+        sceneShaders.base->use();
+        sceneShaders.base->setInt("planeTexture", 0);
+        rg::LightClusters::configureSamplers(*sceneShaders.base);
+        rg::ShadowCascades::configureSamplers(*sceneShaders.base);
+        sceneShaders.cube->use();
+        sceneShaders.cube->setInt("cubeTexture", 0);
+        rg::LightClusters::configureSamplers(*sceneShaders.cube);
+        rg::ShadowCascades::configureSamplers(*sceneShaders.cube);
+        sceneShaders.model->use();
+        rg::LightClusters::configureSamplers(*sceneShaders.model);
+        rg::ShadowCascades::configureSamplers(*sceneShaders.model);
+        sceneShaders.blend->use();
+        sceneShaders.blend->setInt("texture1", 0);
+        sceneShaders.skybox->use();
+        sceneShaders.skybox->setInt("skybox", 0);
+        sceneShaders.gbufferBase->use();
+        sceneShaders.gbufferBase->setInt("planeTexture", 0);
+        sceneShaders.gbufferCube->use();
+        sceneShaders.gbufferCube->setInt("cubeTexture", 0);
+        sceneShaders.deferredLighting->use();
+        sceneShaders.deferredLighting->setInt("gAlbedo", 0);
+        sceneShaders.deferredLighting->setInt("gNormal", 1);
+        sceneShaders.deferredLighting->setInt("gSpecular", 2);
+        sceneShaders.deferredLighting->setInt("gDepth", 3);
+        rg::LightClusters::configureSamplers(*sceneShaders.deferredLighting);
+        rg::ShadowCascades::configureSamplers(*sceneShaders.deferredLighting);
+        brightShader.use();
+        brightShader.setInt("scene", 0);
+        blurShader.use();
+        blurShader.setInt("image", 0);
+        finalShader.use();
+        finalShader.setInt("scene", 0);
+        finalShader.setInt("bloomBlur", 1);
+        taaShader.use();
+        taaShader.setInt("currentColor", 0);
+        taaShader.setInt("velocity", 1);
+        taaShader.setInt("history", 2);
+        luminanceShader.use();
+        luminanceShader.setInt("scene", 0);
+        for (int quality = rg::FXAA_LOW; quality < rg::FXAA_QUALITY_COUNT; ++quality) {
+            fxaaShaders[quality]->use();
+            fxaaShaders[quality]->setInt("screen", 0);
+        }
 
-        float nearestZ = 0.0f;
-        float xPosition;
+        /* Svaki program crtamo jednom u 1x1 cilj svakog rasporeda izlaza koji graf koristi, da
+           drajver zavrsi prevodjenje pre prvog frejma; scena moze biti u oba HDR formata, jer se
+           compactHdr menja i tokom igre */
+        int prewarmPhase = rg::startupTimeline().begin("shader prewarm");
+        for (GLenum sceneFormat : {(GLenum) GL_R11F_G11F_B10F, (GLenum) GL_RGBA16F}) {
+            // scena i deferred osvetljenje: boja i vektori kretanja, sa dubinom
+            shaderLibrary.prewarm({sceneFormat, GL_RG16F});
+            // bright pass i blur (bloom je u formatu scene), TAA izlaz
+            shaderLibrary.prewarm({sceneFormat}, false);
+        }
+        // G-bafer: albedo, normale, spekularno, vektori kretanja
+        shaderLibrary.prewarm({GL_RGBA8, GL_RGBA16F, GL_RGBA8, GL_RG16F});
+        // osvetljenost za automatsku ekspoziciju
+        shaderLibrary.prewarm({GL_R16F}, false);
+        // LDR slika za FXAA i prozor
+        shaderLibrary.prewarm({GL_RGBA8}, false);
+        // senke: samo dubina
+        shaderLibrary.prewarm({});
+        rg::startupTimeline().end(prewarmPhase);
+
+        // everything above changed GL state directly, from here on it goes through the state cache
+        rg::glState().invalidate();
+
+        /* Red za iscrtavanje: scena prijavljuje objekte, red ih sortira po kljucu */
+        rg::RenderQueue renderQueue;
+        std::vector<SceneDraw> sceneDraws;
+        sceneDraws.reserve(256);
+
+        /* Granice objekata u lokalnom prostoru, za odsecanje van frustuma */
+        rg::BoundingSphere groundBounds = rg::sphereFromAABB(rg::AABB{glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, 1.0f)});
+        rg::BoundingSphere cubeBounds = rg::sphereFromAABB(rg::AABB{glm::vec3(-0.5f), glm::vec3(0.5f)});
+        rg::BoundingSphere vegetationBounds = rg::sphereFromAABB(rg::AABB{glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(1.0f, 0.5f, 0.0f)});
+        rg::BoundingSphere pandaBounds = rg::sphereFromAABB(rg::AABB{pandaModel.boundsMin, pandaModel.boundsMax});
+        // skybox is always visible
+        rg::BoundingSphere skyboxBounds(0.0f, 0.0f, 0.0f, std::numeric_limits<float>::infinity());
+
+        std::vector<rg::BoundingSphere> sceneBounds;
+        sceneBounds.reserve(256);
+
+        auto addSceneDraw = [&](SceneObject object, const glm::mat4 &model, bool isPoint, const glm::mat4 &previousModel) {
+            rg::BoundingSphere bounds;
+            switch (object) {
+                case OBJECT_GROUND: bounds = groundBounds; break;
+                case OBJECT_CUBE: bounds = cubeBounds; break;
+                case OBJECT_VEGETATION: bounds = vegetationBounds; break;
+                case OBJECT_PANDA: bounds = pandaBounds; break;
+                case OBJECT_SKYBOX: bounds = skyboxBounds; break;
+            }
+            sceneBounds.push_back(object == OBJECT_SKYBOX ? bounds : rg::transformSphere(model, bounds));
+            sceneDraws.push_back(SceneDraw{object, model, isPoint, previousModel});
+        };
 
-        /* Poeni i prepreke */
-        for(auto it = cubes.begin(); it != cubes.end(); ) {
-            xPosition = (*it)->getXCoord();
-            float zPosition = (*it)->getZCoord();
+        /* U deferred rezimu osvetljeni neprozirni objekti idu u G-bafer (prolaz 0),
+           a emisivni, nebo i providni se crtaju posle osvetljenja (prolaz 1) */
+        auto isDeferredDraw = [&](const SceneDraw &draw) {
+            if (!programState->deferred)
+                return false;
+            return draw.object == OBJECT_GROUND || draw.object == OBJECT_PANDA ||
+                   (draw.object == OBJECT_CUBE && !draw.isPoint);
+        };
 
-            float zNewPosition = zPosition + deltaTime * programState->cubesSpeed;
+        auto shaderFor = [&](const SceneDraw &draw) -> Shader & {
+            bool gbuffer = isDeferredDraw(draw);
+            switch (draw.object) {
+                case OBJECT_GROUND: return gbuffer ? *shaders->gbufferBase : *shaders->base;
+                case OBJECT_CUBE:
+                    if (draw.isPoint)
+                        return *shaders->point;
+                    return gbuffer ? *shaders->gbufferCube : *shaders->cube;
+                case OBJECT_VEGETATION: return *shaders->blend;
+                case OBJECT_PANDA: return gbuffer ? *shaders->gbufferModel : *shaders->model;
+                case OBJECT_SKYBOX: break;
+            }
+            return *shaders->skybox;
+        };
 
-            if(nearestZ  >= zPosition ) {
-                nearestZ = zPosition;
+        auto submitDraw = [&](uint32_t index) {
+            const SceneDraw &draw = sceneDraws[index];
+            const glm::mat4 &model = draw.model;
+            unsigned int material = 0;
+            rg::RenderLayer layer = rg::LAYER_OPAQUE;
+            switch (draw.object) {
+                case OBJECT_GROUND: material = planeTexture; break;
+                case OBJECT_CUBE: material = draw.isPoint ? 0 : cubeTexture; break;
+                case OBJECT_VEGETATION: material = vegetationTexture; layer = rg::LAYER_TRANSPARENT; break;
+                case OBJECT_PANDA: break;
+                case OBJECT_SKYBOX: material = cubemapTexture; layer = rg::LAYER_SKY; break;
             }
+            unsigned int pass = programState->deferred && !isDeferredDraw(draw) ? 1 : 0;
+            float distance = glm::length(glm::vec3(model[3]) - camera.Position);
+            uint64_t key = rg::makeSortKey(pass, layer, shaderFor(draw).ID, material,
+                                           rg::quantizeDepth(distance, NEAR_PLANE, FAR_PLANE));
+            renderQueue.submit(key, index);
+        };
 
-            if((zNewPosition  >= 0.9f && !(*it)->isPoint()) || (zNewPosition  >= 1.0f && (*it)->isPoint()) ){
-                delete *it;
-                it = cubes.erase(it);
-                continue;
+        auto drawSceneObject = [&](const rg::DrawPacket &packet) {
+            const SceneDraw &draw = sceneDraws[packet.index];
+            Shader &shader = shaderFor(draw);
+            switch (draw.object) {
+                case OBJECT_GROUND:
+                    shader.use();
+                    rg::glState().disable(GL_CULL_FACE);
+                    rg::glState().bindVertexArray(planeVAO);
+                    rg::glState().bindTexture(0, GL_TEXTURE_2D, planeTexture);
+                    shader.setMat4("model", draw.model);
+                    shader.setMat4("previousModel", draw.previousModel);
+                    rg::drawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                    break;
+                case OBJECT_CUBE:
+                    shader.use();
+                    rg::glState().enable(GL_CULL_FACE);
+                    rg::glState().frontFace(GL_CW);
+                    rg::glState().bindVertexArray(cubeVAO);
+                    if (!draw.isPoint)
+                        rg::glState().bindTexture(0, GL_TEXTURE_2D, cubeTexture);
+                    shader.setMat4("model", draw.model);
+                    shader.setMat4("previousModel", draw.previousModel);
+                    rg::drawArrays(GL_TRIANGLES, 0, 36);
+                    break;
+                case OBJECT_VEGETATION:
+                    shader.use();
+                    rg::glState().disable(GL_CULL_FACE);
+                    rg::glState().bindVertexArray(transparentVAO);
+                    rg::glState().bindTexture(0, GL_TEXTURE_2D, vegetationTexture);
+                    shader.setMat4("model", draw.model);
+                    shader.setMat4("previousModel", draw.previousModel);
+                    rg::drawArrays(GL_TRIANGLES, 0, 6);
+                    break;
+                case OBJECT_PANDA:
+                    shader.use();
+                    rg::glState().disable(GL_CULL_FACE);
+                    shader.setMat4("model", draw.model);
+                    shader.setMat4("previousModel", draw.previousModel);
+                    pandaModel.Draw(shader);
+                    break;
+                case OBJECT_SKYBOX:
+                    shader.use();
+                    rg::glState().disable(GL_CULL_FACE);
+                    rg::glState().depthMask(GL_FALSE);
+                    rg::glState().depthFunc(GL_LEQUAL);
+                    rg::glState().bindVertexArray(skyboxVAO);
+                    rg::glState().bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
+                    shader.setMat4("previousModel", draw.previousModel);
+                    rg::drawArrays(GL_TRIANGLES,0,36);
+                    rg::glState().depthMask(GL_TRUE);
+                    rg::glState().depthFunc(GL_LESS);
+                    break;
             }
+        };
 
-            /* Detekcija kolizije */
+        // deo ciljeva u koji se scena crta u tekucem frejmu i koliki je to deo teksture
+        glm::ivec2 renderSize(SCR_WIDTH, SCR_HEIGHT);
+        glm::vec2 uvScale(1.0f);
+        rg::DynamicResolution dynamicResolution;
+        // stanje prethodnog frejma za vektore kretanja
+        glm::mat4 previousViewProjection(1.0f);
+        glm::mat4 previousSkyViewProjection(1.0f);
+        glm::mat4 previousPandaModel(1.0f);
+        bool taaWasEnabled = false;
+
+        /* Osvetljenje iz G-bafera u hdrFBO, pa dubina G-bafera za objekte koji se crtaju posle */
+        // teksture G-bafera vezuje pozivalac, na jedinice 0-3
+        auto resolveDeferredLighting = [&](GLuint gBufferFBO) {
+            rg::glState().bindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+            // vektore kretanja je vec upisao G-bafer prolaz
+            glColorMaski(1, GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glClear(GL_COLOR_BUFFER_BIT);
+            shaders->deferredLighting->use();
+            rg::glState().disable(GL_DEPTH_TEST);
+            rg::glState().disable(GL_CULL_FACE);
+            renderQuad();
+            glColorMaski(1, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            rg::glState().enable(GL_DEPTH_TEST);
 
-            // naisli na prepreku
-            if(zNewPosition >= 0.6 && xPandaPosition == xPosition && !(*it)->isPoint()){
-                cubes.clear();
-                isGameOver = true;
-                if (programState->highScore < programState->score)
-                    programState->highScore = programState->score;
-                programState->score = 0;
-                break;
-            }
+            rg::glState().bindFramebuffer(GL_READ_FRAMEBUFFER, gBufferFBO);
+            glBlitFramebuffer(0, 0, renderSize.x, renderSize.y, 0, 0, renderSize.x, renderSize.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            rg::glState().bindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+        };
 
-            // naisli na poen
-            if(zNewPosition >= 0.65 && xPandaPosition == xPosition  && (*it)->isPoint()){
-                delete *it;
-                it = cubes.erase(it);
-                programState->score++;
-                std::cerr << "Score " << programState->score <<std::endl;
+        benchmark.start({"forward", "deferred"}, benchmarkFrames);
+        rg::GpuTimer sceneTimer;
+        rg::GpuTimer postTimer;
+        // merenja ne smeju da zavise od rezolucije koju bira kontroler
+        if (benchmarkFrames > 0)
+            programState->resolution.enabled = false;
+        // izvestaj o zastoju alocira, a u proveri se broji svaka alokacija
+        allocationCheck.start(allocationCheckFrames);
+        if (allocationCheck.running())
+            programState->hitches.enabled = false;
+        uint32_t frameNumber = 0;
+        // slika se cita kroz prsten PBO-a, konverzija i upis su na posebnoj niti
+        rg::FrameCapture frameCapture;
+        auto startCapture = [&](const std::string &path) {
+            bool y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+            if (!frameCapture.start(path, y4m ? rg::CAPTURE_Y4M : rg::CAPTURE_PPM))
+                std::cout << "Failed to open " << path << " for capture" << std::endl;
+        };
+        if (!capturePath.empty())
+            startCapture(capturePath);
+        // GPU vreme svakog prolaza grafa, stize nekoliko frejmova kasnije
+        rg::GpuPassTimer passTimer;
+        rg::HitchDetector hitchDetector("hitches.log");
+
+
+        // od prvog prolaza kroz petlju dok prvi frejm ne bude prikazan
+        int firstFramePhase = rg::startupTimeline().begin("first frame");
+
+           // render loop
+        // -----------
+        while (!glfwWindowShouldClose(window)) {
+            // provera alokacija pokriva ceo frejm, i pocetak frejma ispod
+            allocationCheck.beginFrame();
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+            // minimizovan prozor nema sta da prikaze
+            if (framebufferWidth == 0 || framebufferHeight == 0) {
+                glfwWaitEvents();
                 continue;
             }
-
-            glm::mat4 model = (*it)->translateCube(xPosition, 0.5f, zNewPosition);
-
-            cubeShader.setMat4("model", model);
-            cubeShader.setBool("isPoint",(*it)->isPoint());
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-            ++it;
-
-        }
-
-        glDisable(GL_CULL_FACE);
-
-        /* Vegetacija */
-
-        glBindVertexArray(transparentVAO);
-
-        blendShader.use();
-        blendShader.setMat4("view",view);
-        blendShader.setMat4("projection",projection);
-        blendShader.setInt("texture1",0);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, vegetationTexture);
-
-        setUpShaderLights(blendShader);
-
-        for(auto it = cubes.begin(); it != cubes.end(); it++ ) {
-            Cube* cube = *it;
-            if (!cube->isPoint()) {
-                float xPos = cube->getXCoord();
-                float yPos = cube->getYCoord();
-                float zPos = cube->getZCoord() + 0.2f;
-
+            // per-frame time logic
+            // --------------------
+            rg::frameStats().current().arenaBytes = rg::frameArena().usedBytes();
+            rg::glState().beginFrame();
+            rg::frameStats().beginFrame(rg::glState().lastFrame());
+            rg::frameArena().beginFrame();
+            rg::cpuProfiler().beginFrame();
+            double frameStart = glfwGetTime();
+            if (benchmark.running())
+                programState->deferred = benchmark.mode() == 1;
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+
+            // input
+            // -----
+            int inputZone = rg::cpuProfiler().begin("input");
+            processInput(window);
+            rg::cpuProfiler().end(inputZone);
+
+            // render
+            // ------
+            glClearColor(0.0f, 0.7f, 1.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            /* Ciljevi prate prozor, scena se crta u rezoluciji koju je izabrao kontroler */
+            int setupZone = rg::cpuProfiler().begin("frame setup");
+            resizeRenderTargets(framebufferWidth, framebufferHeight);
+            GLenum sceneColorFormat = programState->compactHdr ? GL_R11F_G11F_B10F : GL_RGBA16F;
+            if (hdrTarget.colorFormat(0) != sceneColorFormat) {
+                hdrTarget.setColorFormat(0, sceneColorFormat);
+                rg::glState().invalidate();
+                temporalAA.reset();
+            }
+            renderSize = dynamicResolution.renderSize(framebufferWidth, framebufferHeight);
+            uvScale = glm::vec2(renderSize) / glm::vec2(framebufferWidth, framebufferHeight);
+            sceneRenderScale = dynamicResolution.scale();
+            sceneRenderSize = renderSize;
+            float aspect = (float)framebufferWidth/(float)framebufferHeight;
+            rg::cpuProfiler().end(setupZone);
+
+            /* 1. Priprema scene na CPU, prolazi na GPU se prijavljuju grafu frejma kad je sve spremno */
+            int gameZone = rg::cpuProfiler().begin("game update");
+            glm::mat4 view = camera.GetViewMatrix();
+            glm::mat4 unjitteredProjection = glm::perspective(glm::radians(camera.Zoom), aspect, NEAR_PLANE, FAR_PLANE);
+            // sa TAA svaki frejm je pomeren za drugi deo piksela
+            glm::vec2 jitter = programState->taa ? rg::taaJitter(frameNumber) : glm::vec2(0.0f);
+            glm::mat4 projection = rg::jitterProjection(unjitteredProjection, jitter, renderSize);
+            glm::mat4 motionViewProjection = unjitteredProjection * view;
+            glm::mat4 skyViewProjection = unjitteredProjection * glm::mat4(glm::mat3(view));
+
+            sceneDraws.clear();
+            sceneBounds.clear();
+            renderQueue.clear();
+
+            /* Podloga */
+            for(unsigned int i = 0; i< 10; i++){
                 glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(xPos - 0.4, yPos, zPos));
-                model = glm::scale(model, glm::vec3(0.6));
-                blendShader.setMat4("model", model);
-                glDrawArrays(GL_TRIANGLES, 0, 6);
+                model = glm::translate(model, glm::vec3(0.0f,0.0f,-2.0f * i));
+                addSceneDraw(OBJECT_GROUND, model, false, model);
             }
-        }
 
-        if(nearestZ > -5.0f && !isGameOver) {
-            Cube* newCube = new Cube(false);
-            cubes.push_back(newCube);
-            Cube* newPointCube = new Cube(newCube->getXCoord(), true);
-            cubes.push_back(newPointCube);
-        }
-
-        /* Renderovanje modela */
-
-        modelShader.use();
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(xPandaPosition, 0.6f, 0.7f));
-        model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-
-        model = glm::scale(model, glm::vec3(0.007f));
-
-        modelShader.setMat4("projection", projection);
-        modelShader.setMat4("view", view);
-        modelShader.setMat4("model", model);
-        setUpShaderLights(modelShader);
-
-        pandaModel.Draw(modelShader);
+            float nearestZ = 0.0f;
+            float xPosition;
+
+            /* Poeni i prepreke */
+            for(auto it = cubes.begin(); it != cubes.end(); ) {
+                xPosition = it->getXCoord();
+                float zPosition = it->getZCoord();
+
+                float zNewPosition = zPosition + deltaTime * programState->cubesSpeed;
+
+                if(nearestZ  >= zPosition ) {
+                    nearestZ = zPosition;
+                }
+
+                if((zNewPosition  >= 0.9f && !it->isPoint()) || (zNewPosition  >= 1.0f && it->isPoint()) ){
+                    it = cubes.erase(it);
+                    continue;
+                }
+
+                /* Detekcija kolizije */
+
+                // naisli na prepreku
+                // u benchmark-u igra ne sme da se zavrsi, scena bi ostala prazna
+                if(zNewPosition >= 0.6 && xPandaPosition == xPosition && !it->isPoint() && !benchmark.running() &&
+                   !allocationCheck.running()){
+                    cubes.clear();
+                    isGameOver = true;
+                    if (programState->highScore < programState->score)
+                        programState->highScore = programState->score;
+                    programState->score = 0;
+                    break;
+                }
+
+                // naisli na poen
+                if(zNewPosition >= 0.65 && xPandaPosition == xPosition  && it->isPoint()){
+                    it = cubes.erase(it);
+                    programState->score++;
+                    // bez flush-a, sinhrono pisanje na konzolu je usred frejma pravilo zastoje
+                    std::cout << "Score " << programState->score << '\n';
+                    continue;
+                }
+
+                glm::mat4 model = it->translateCube(xPosition, 0.5f, zNewPosition);
+                // prepreke se krecu samo po z
+                glm::mat4 previousModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, zPosition - zNewPosition)) * model;
+                addSceneDraw(OBJECT_CUBE, model, it->isPoint(), previousModel);
+                ++it;
 
+            }
 
-        glDepthMask(GL_FALSE);
-        glDepthFunc(GL_LEQUAL);
+            /* Vegetacija */
+
+            for(auto it = cubes.begin(); it != cubes.end(); it++ ) {
+                const Cube &cube = *it;
+                if (!cube.isPoint()) {
+                    float xPos = cube.getXCoord();
+                    float yPos = cube.getYCoord();
+                    float zPos = cube.getZCoord() + 0.2f;
+
+                    glm::mat4 model = glm::mat4(1.0f);
+                    model = glm::translate(model, glm::vec3(xPos - 0.4, yPos, zPos));
+                    model = glm::scale(model, glm::vec3(0.6));
+                    glm::mat4 previousModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -deltaTime * programState->cubesSpeed)) * model;
+                    addSceneDraw(OBJECT_VEGETATION, model, false, previousModel);
+                }
+            }
 
-        skyboxShader.use();
+            if(nearestZ > -5.0f && !isGameOver) {
+                cubes.push_back(Cube(false));
+                cubes.push_back(Cube(cubes.back().getXCoord(), true));
+            }
 
-        //eliminisemo translaciju da bi kocka izgledala beskonacno daleko
-        skyboxShader.setMat4("view",glm::mat4(glm::mat3(view)));
+            /* Renderovanje modela */
 
-        skyboxShader.setMat4("projection",projection);
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(xPandaPosition, 0.6f, 0.7f));
+            model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+
+            model = glm::scale(model, glm::vec3(0.007f));
+            addSceneDraw(OBJECT_PANDA, model, false, previousPandaModel);
+            previousPandaModel = model;
+
+            addSceneDraw(OBJECT_SKYBOX, glm::mat4(1.0f), false, glm::mat4(1.0f));
+            rg::cpuProfiler().end(gameZone);
+
+            /* Svetla po klasterima: staticka svetla i svetleci poeni */
+            int lightsZone = rg::cpuProfiler().begin("light clusters");
+            lightClusters.clear();
+            for (int i = 0; i < programState->numOfPointLights; i++) {
+                const PointLight &light = programState->pointLights[i];
+                lightClusters.addLight(rg::makeClusterLight(light.position, light.ambient, light.diffuse, light.specular,
+                                                            light.constant, light.linear, light.quadratic));
+            }
+            if (programState->pickupLights) {
+                for (const SceneDraw &draw : sceneDraws) {
+                    if (draw.object == OBJECT_CUBE && draw.isPoint)
+                        lightClusters.addLight(rg::makeClusterLight(glm::vec3(draw.model[3]), glm::vec3(0.0f),
+                                                                    PICKUP_LIGHT_COLOR, PICKUP_LIGHT_COLOR, 1.0f, 0.7f, 1.8f));
+                }
+            }
+            lightClusters.build(view, projection, NEAR_PLANE, FAR_PLANE, glm::vec2(renderSize));
+            lightClusters.bind();
+            clusteredLightCount = lightClusters.lightCount();
+            clusteredLightEntries = lightClusters.indexCount();
+            rg::cpuProfiler().end(lightsZone);
+
+            /* Kaskade senki za ovaj frejm, iscrtavaju se u prolazu grafa */
+            int cascadesZone = rg::cpuProfiler().begin("shadow cascades");
+            shadowCascades.update(programState->shadows, view, glm::radians(camera.Zoom), aspect, NEAR_PLANE, programState->dirLight.direction);
+            rg::cpuProfiler().end(cascadesZone);
+
+            /* Uniforme koje su iste za sve objekte u frejmu */
+            int uniformsZone = rg::cpuProfiler().begin("frame uniforms");
+            if (programState->deferred) {
+                Shader *gbufferShaders[] = {shaders->gbufferBase, shaders->gbufferCube, shaders->gbufferModel};
+                for (Shader *shader : gbufferShaders) {
+                    shader->use();
+                    shader->setMat4("projection", projection);
+                    shader->setMat4("view", view);
+                }
+                shaders->deferredLighting->use();
+                shaders->deferredLighting->setMat4("inverseViewProjection", glm::inverse(projection * view));
+                shaders->deferredLighting->setVec2("uvScale", uvScale);
+                setUpShaderLights(*shaders->deferredLighting, lightClusters, shadowCascades);
+            } else {
+                shaders->base->use();
+                shaders->base->setMat4("projection", projection);
+                shaders->base->setMat4("view", view);
+                setUpShaderLights(*shaders->base, lightClusters, shadowCascades);
+
+                shaders->cube->use();
+                shaders->cube->setMat4("projection", projection);
+                shaders->cube->setMat4("view", view);
+                setUpShaderLights(*shaders->cube, lightClusters, shadowCascades);
+
+                shaders->model->use();
+                shaders->model->setMat4("projection", projection);
+                shaders->model->setMat4("view", view);
+                setUpShaderLights(*shaders->model, lightClusters, shadowCascades);
+            }
 
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES,0,36);
+            shaders->point->use();
+            shaders->point->setMat4("projection", projection);
+            shaders->point->setMat4("view", view);
+
+            shaders->blend->use();
+            shaders->blend->setMat4("view",view);
+            shaders->blend->setMat4("projection",projection);
+
+            shaders->skybox->use();
+            //eliminisemo translaciju da bi kocka izgledala beskonacno daleko
+            shaders->skybox->setMat4("view",glm::mat4(glm::mat3(view)));
+            shaders->skybox->setMat4("projection",projection);
+            shaders->skybox->setMat4("motionViewProjection", skyViewProjection);
+            shaders->skybox->setMat4("previousViewProjection", previousSkyViewProjection);
+
+            Shader *motionShaders[] = {shaders->base, shaders->cube, shaders->model, shaders->point, shaders->blend,
+                                       shaders->gbufferBase, shaders->gbufferCube, shaders->gbufferModel};
+            for (Shader *shader : motionShaders) {
+                shader->use();
+                shader->setMat4("motionViewProjection", motionViewProjection);
+                shader->setMat4("previousViewProjection", previousViewProjection);
+            }
+            rg::cpuProfiler().end(uniformsZone);
+
+
+            /* Odsecanje van frustuma, u red idu samo vidljivi objekti */
+            int cullZone = rg::cpuProfiler().begin("culling and sort");
+            rg::Frustum frustum(projection * view);
+            // vidljivost vazi samo ovaj frejm, pa ide u arenu frejma
+            rg::FrameVector<uint8_t> sceneVisibility(sceneBounds.size());
+            culledObjects = frustum.cullSpheres(sceneBounds.data(), sceneBounds.size(), sceneVisibility.data());
+            rg::frameStats().current().culledObjects = culledObjects;
+            for (uint32_t i = 0; i < sceneDraws.size(); i++) {
+                if (sceneVisibility[i])
+                    submitDraw(i);
+            }
 
-        glDepthMask(GL_TRUE);
-        glDepthFunc(GL_LESS);
+            /* Sortiramo sve sto je scena prijavila */
+            renderQueue.sort();
+            rg::cpuProfiler().end(cullZone);
+
+            /* 2. Graf frejma: svaki prolaz prijavljuje sta cita i pise, prolazi ciji rezultat niko
+               ne koristi se preskacu (npr. blur kad je bloom iskljucen) */
+            int graphZone = rg::cpuProfiler().begin("graph setup");
+            renderGraph.beginFrame(framebufferWidth, framebufferHeight);
+            rg::GraphResource backbuffer = renderGraph.importBackbuffer();
+            rg::GraphResource shadowMap = renderGraph.importTexture("shadow map", shadowCascades.texture());
+            rg::GraphResource hdrColor = renderGraph.importTexture("hdr color", colorBuffer);
+            rg::GraphResource velocity = renderGraph.importTexture("velocity", velocityBuffer);
+
+            /* Senke: podloga je staticna i crta se samo kad se kaskada pomeri, prepreke i panda svaki frejm */
+            renderGraph.addPass("shadows", [&](rg::PassBuilder &pass) {
+                pass.write(shadowMap);
+            }, [&]() {
+                shadowCascades.render([&](bool staticCasters, const glm::mat4 &lightSpace, const rg::Frustum &bounds) {
+                    unsigned int draws = 0;
+                    shadowShader.use();
+                    shadowShader.setMat4("lightSpace", lightSpace);
+                    for (size_t i = 0; i < sceneDraws.size(); i++) {
+                        const SceneDraw &draw = sceneDraws[i];
+                        bool isStatic = draw.object == OBJECT_GROUND;
+                        bool isDynamic = draw.object == OBJECT_PANDA || (draw.object == OBJECT_CUBE && !draw.isPoint);
+                        if ((staticCasters ? !isStatic : !isDynamic) || !bounds.isVisible(sceneBounds[i]))
+                            continue;
+                        shadowShader.setMat4("model", draw.model);
+                        if (draw.object == OBJECT_GROUND) {
+                            rg::glState().bindVertexArray(planeVAO);
+                            rg::drawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                        } else if (draw.object == OBJECT_CUBE) {
+                            rg::glState().bindVertexArray(cubeVAO);
+                            rg::drawArrays(GL_TRIANGLES, 0, 36);
+                        } else {
+                            pandaModel.Draw(shadowShader);
+                        }
+                        draws++;
+                    }
+                    return draws;
+                });
+                shadowCascades.bind();
+                shadowDraws = shadowCascades.draws();
+                shadowStaticRefreshes = shadowCascades.staticRefreshes();
+            });
+
+            /* U deferred rezimu prvo G-bafer pa osvetljenje iz njega */
+            rg::GraphResource gAlbedo = rg::GRAPH_NONE, gNormal = rg::GRAPH_NONE, gSpecular = rg::GRAPH_NONE,
+                    gDepth = rg::GRAPH_NONE;
+            if (programState->deferred) {
+                gAlbedo = renderGraph.createTexture("G albedo", {GL_RGBA8, GL_NEAREST});
+                gNormal = renderGraph.createTexture("G normal", {GL_RGBA16F, GL_NEAREST});
+                gSpecular = renderGraph.createTexture("G specular", {GL_RGBA8, GL_NEAREST});
+                gDepth = renderGraph.createTexture("G depth", {GL_DEPTH_COMPONENT24, GL_NEAREST});
+                renderGraph.addPass("G-buffer", [&](rg::PassBuilder &pass) {
+                    pass.write(gAlbedo);
+                    pass.write(gNormal);
+                    pass.write(gSpecular);
+                    pass.write(gDepth);
+                    pass.write(velocity);
+                }, [&]() {
+                    rg::glState().bindFramebuffer(GL_FRAMEBUFFER, renderGraph.framebuffer({gAlbedo, gNormal, gSpecular, velocity}, gDepth));
+                    glViewport(0, 0, renderSize.x, renderSize.y);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    renderQueue.executePass(0, drawSceneObject);
+                });
+                renderGraph.addPass("deferred lighting", [&](rg::PassBuilder &pass) {
+                    pass.read(gAlbedo);
+                    pass.read(gNormal);
+                    pass.read(gSpecular);
+                    pass.read(gDepth);
+                    pass.read(shadowMap);
+                    pass.write(hdrColor);
+                }, [&]() {
+                    renderGraph.bindTexture(0, gAlbedo);
+                    renderGraph.bindTexture(1, gNormal);
+                    renderGraph.bindTexture(2, gSpecular);
+                    renderGraph.bindTexture(3, gDepth);
+                    resolveDeferredLighting(renderGraph.framebuffer({gAlbedo, gNormal, gSpecular, velocity}, gDepth));
+                });
+            }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            /* Forward: cela scena, ili u deferred rezimu emisivni objekti, nebo i providni preko osvetljenja */
+            renderGraph.addPass("forward", [&](rg::PassBuilder &pass) {
+                pass.read(shadowMap);
+                if (programState->deferred) {
+                    pass.read(hdrColor);
+                    pass.read(velocity);
+                }
+                pass.write(hdrColor);
+                pass.write(velocity);
+            }, [&]() {
+                rg::glState().bindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+                glViewport(0, 0, renderSize.x, renderSize.y);
+                if (!programState->deferred)
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                renderQueue.executePass(programState->deferred ? 1 : 0, drawSceneObject);
+
+                rg::glState().disable(GL_CULL_FACE);
+                rg::glState().depthMask(GL_TRUE);
+                rg::glState().depthFunc(GL_LESS);
+                // GPU vreme scene se meri do ovde, ostalo je obrada slike
+                sceneTimer.end();
+                postTimer.begin();
+            });
+
+            /* TAA: trenutni frejm se spaja sa istorijom, rezultat je u rezoluciji prozora */
+            rg::GraphResource taaOutput = rg::GRAPH_NONE, taaHistory = rg::GRAPH_NONE;
+            if (programState->taa) {
+                if (!taaWasEnabled)
+                    temporalAA.reset();
+                taaHistory = renderGraph.importTexture("TAA history", temporalAA.historyTexture());
+                taaOutput = renderGraph.importTexture("TAA output", temporalAA.outputTexture());
+                renderGraph.addPass("TAA", [&](rg::PassBuilder &pass) {
+                    pass.read(hdrColor);
+                    pass.read(velocity);
+                    pass.read(taaHistory);
+                    pass.write(taaOutput);
+                }, [&]() {
+                    rg::glState().bindFramebuffer(GL_FRAMEBUFFER, temporalAA.outputFramebuffer());
+                    glViewport(0, 0, framebufferWidth, framebufferHeight);
+                    taaShader.use();
+                    taaShader.setVec2("uvScale", uvScale);
+                    taaShader.setVec2("jitter", jitter);
+                    taaShader.setBool("historyValid", temporalAA.historyValid());
+                    taaShader.setFloat("blendFactor", 0.1f);
+                    renderGraph.bindTexture(0, hdrColor);
+                    renderGraph.bindTexture(1, velocity);
+                    renderGraph.bindTexture(2, taaHistory);
+                    renderQuad();
+                    // ovaj izlaz postaje istorija sledeceg frejma
+                    temporalAA.advance();
+                });
+            }
+            taaWasEnabled = programState->taa;
+            rg::GraphResource sceneColor = programState->taa ? taaOutput : hdrColor;
+            glm::vec2 sceneUvScale = programState->taa ? glm::vec2(1.0f) : uvScale;
+
+            /* Automatska ekspozicija: osvetljenost scene se svodi na jedan teksel i cita asinhrono,
+               ekspozicija se polako pomera ka vrednosti koja iz nje sledi */
+            autoExposure.update(programState->autoExposure, deltaTime);
+            sceneAverageLuminance = autoExposure.averageLuminance();
+            frameExposure = programState->autoExposure.enabled ? autoExposure.exposure() : programState->exposure;
+            if (programState->autoExposure.enabled) {
+                rg::GraphResource luminance = renderGraph.importOutput("luminance", autoExposure.texture());
+                renderGraph.addPass("luminance", [&](rg::PassBuilder &pass) {
+                    pass.read(hdrColor);
+                    pass.write(luminance);
+                }, [&]() {
+                    rg::glState().bindFramebuffer(GL_FRAMEBUFFER, autoExposure.framebuffer());
+                    glViewport(0, 0, rg::AutoExposure::SIZE, rg::AutoExposure::SIZE);
+                    luminanceShader.use();
+                    luminanceShader.setVec2("uvScale", uvScale);
+                    renderGraph.bindTexture(0, hdrColor);
+                    renderQuad();
+                    autoExposure.queueReadback();
+                });
+            }
 
-        /* 2. Blurujemo bright fragmente */
+            /* Bloom: svetli delovi scene se izdvajaju u manju teksturu pa se ona zamuti */
+            GLenum bloomFormat = programState->compactHdr ? GL_R11F_G11F_B10F : GL_RGBA16F;
+            int bloomDownsample = programState->bloomDownsample;
+            glm::ivec2 bloomSize(rg::RenderGraph::downsampled(renderSize.x, bloomDownsample),
+                                 rg::RenderGraph::downsampled(renderSize.y, bloomDownsample));
+            glm::vec2 bloomUvScale = glm::vec2(bloomSize) /
+                                     glm::vec2(rg::RenderGraph::downsampled(framebufferWidth, bloomDownsample),
+                                               rg::RenderGraph::downsampled(framebufferHeight, bloomDownsample));
+            // u manjoj rezoluciji je svaki teksel veci, pa je za isti radijus dovoljno manje iteracija blura
+            unsigned int blurIterations = (50 / (bloomDownsample * bloomDownsample) + 1) & ~1u;
+            rg::GraphResource bloom = renderGraph.createTexture("bloom", {bloomFormat, GL_LINEAR, bloomDownsample});
+            rg::GraphResource bloomScratch = renderGraph.createTexture("bloom scratch", {bloomFormat, GL_LINEAR, bloomDownsample});
+            renderGraph.addPass("bright pass", [&](rg::PassBuilder &pass) {
+                pass.read(hdrColor);
+                pass.write(bloom);
+            }, [&]() {
+                rg::glState().bindFramebuffer(GL_FRAMEBUFFER, renderGraph.framebuffer({bloom}));
+                glViewport(0, 0, bloomSize.x, bloomSize.y);
+                brightShader.use();
+                brightShader.setVec2("uvScale", uvScale);
+                brightShader.setInt("downsample", bloomDownsample);
+                renderGraph.bindTexture(0, hdrColor);
+                renderQuad();
+            });
+            renderGraph.addPass("bloom blur", [&](rg::PassBuilder &pass) {
+                pass.read(bloom);
+                pass.write(bloom);
+                pass.write(bloomScratch);
+            }, [&]() {
+                // polazi od bloom, a broj iteracija je paran, pa i poslednja upisuje u bloom
+                GLuint pingpongFBO[2] = {renderGraph.framebuffer({bloom}), renderGraph.framebuffer({bloomScratch})};
+                rg::GraphResource pingpongColorbuffers[2] = {bloom, bloomScratch};
+                glViewport(0, 0, bloomSize.x, bloomSize.y);
+                bool horizontal = true;
+                unsigned int amount = blurIterations;
+                blurShader.use();
+                blurShader.setVec2("uvScale", bloomUvScale);
+                for (unsigned int i = 0; i < amount; i++)
+                {
+                    rg::glState().bindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
+                    blurShader.setInt("horizontal", horizontal);
+                    renderGraph.bindTexture(0, pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer
+                    renderQuad();
+                    horizontal = !horizontal;
+                }
+            });
+
+            /* 3. Spajamo sve, uz uvecanje do velicine prozora; sa FXAA zavrsni prolaz ide u
+               medjucilj, a tek FXAA u prozor */
+            bool fxaa = programState->fxaa != rg::FXAA_OFF;
+            rg::GraphResource ldr = fxaa ? renderGraph.createTexture("ldr", {GL_RGBA8, GL_LINEAR}) : rg::GRAPH_NONE;
+            renderGraph.addPass("composite", [&](rg::PassBuilder &pass) {
+                pass.read(sceneColor);
+                if (programState->bloom)
+                    pass.read(bloom);
+                pass.write(fxaa ? ldr : backbuffer);
+            }, [&]() {
+                rg::glState().bindFramebuffer(GL_FRAMEBUFFER, fxaa ? renderGraph.framebuffer({ldr}) : 0);
+                glViewport(0, 0, framebufferWidth, framebufferHeight);
+
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                finalShader.use();
+                renderGraph.bindTexture(0, sceneColor);
+                if (programState->bloom)
+                    renderGraph.bindTexture(1, bloom);
+                finalShader.setInt("bloom", programState->bloom);
+                finalShader.setFloat("exposure", frameExposure);
+                finalShader.setVec2("uvScale", sceneUvScale);
+                finalShader.setVec2("bloomUvScale", bloomUvScale);
+                // TAA malo omeksava sliku, pa se tada izostrava i u punoj rezoluciji
+                bool sharpen = programState->taa || renderSize.x < framebufferWidth;
+                finalShader.setFloat("sharpness", sharpen ? programState->resolution.sharpness : 0.0f);
+                finalShader.setBool("lumaInAlpha", fxaa);
+                renderQuad();
+            });
+
+            if (fxaa) {
+                renderGraph.addPass("FXAA", [&](rg::PassBuilder &pass) {
+                    pass.read(ldr);
+                    pass.write(backbuffer);
+                }, [&]() {
+                    rg::FxaaQuality quality = (rg::FxaaQuality) programState->fxaa;
+                    rg::glState().bindFramebuffer(GL_FRAMEBUFFER, 0);
+                    fxaaShaders[quality]->use();
+                    rg::Fxaa::setUniforms(*fxaaShaders[quality], quality);
+                    renderGraph.bindTexture(0, ldr);
+                    renderQuad();
+                });
+            }
 
-        bool horizontal = true, first_iteration = true;
-        unsigned int amount = 50;
-        blurShader.use();
-        for (unsigned int i = 0; i < amount; i++)
-        {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            blurShader.setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);  // bind texture of other framebuffer (or scene if first iteration)
-            renderQuad();
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            renderGraph.compile();
+            rg::cpuProfiler().end(graphZone);
 
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            /* Procena: upis scene, bright pass, blur i citanje u zavrsnom prolazu; bez overdraw-a */
+            {
+                size_t windowPixels = (size_t) framebufferWidth * framebufferHeight;
+                size_t scenePixels = (size_t) renderSize.x * renderSize.y;
+                size_t bloomPixels = (size_t) bloomSize.x * bloomSize.y;
+                size_t bloomTexturePixels = (size_t) rg::RenderGraph::downsampled(framebufferWidth, bloomDownsample) *
+                                            rg::RenderGraph::downsampled(framebufferHeight, bloomDownsample);
+                size_t sceneBytes = rg::bytesPerPixel(sceneColorFormat);
+                size_t bloomBytes = rg::bytesPerPixel(bloomFormat);
+                hdrTargetBytes = windowPixels * sceneBytes;
+                hdrTrafficBytes = scenePixels * sceneBytes * 2;
+                if (programState->bloom) {
+                    hdrTargetBytes += 2 * bloomTexturePixels * bloomBytes;
+                    hdrTrafficBytes += scenePixels * sceneBytes + bloomPixels * bloomBytes * (1 + 2 * blurIterations + 1);
+                }
+                // scena i bright u dva RGBA16F cilja, dva RGBA16F ping-pong cilja, 50 iteracija blura
+                hdrTargetBaselineBytes = windowPixels * 8 * (programState->bloom ? 4 : 1);
+                hdrTrafficBaselineBytes = scenePixels * 8 * (programState->bloom ? 2 + 1 + 2 * 50 + 1 : 2);
+            }
+            renderGraphPasses = renderGraph.passCount();
+            renderGraphCulledPasses = renderGraph.culledPassCount();
+            renderGraphTransientBytes = renderGraph.transientBytes();
+            renderGraphUnaliasedBytes = renderGraph.transientBytesWithoutAliasing();
+            if (dumpRenderGraph) {
+                renderGraph.dump(std::cout);
+                dumpRenderGraph = false;
+            }
 
-        /* 3. Spajamo sve */
+            sceneTimer.begin(benchmark.running() ? benchmark.frame() : frameNumber);
+            int executeZone = rg::cpuProfiler().begin("graph execute");
+            passTimer.beginFrame(frameNumber);
+            renderGraph.execute(&passTimer);
+            passTimer.endFrame();
+            rg::cpuProfiler().end(executeZone);
+            postTimer.end();
+
+            /* Snimanje: gotova slika, bez ImGui prozora */
+            int captureZone = rg::cpuProfiler().begin("capture");
+            if (captureToggleRequested) {
+                captureToggleRequested = false;
+                if (frameCapture.recording())
+                    frameCapture.stop();
+                else
+                    startCapture(capturePath.empty() ? "capture.y4m" : capturePath);
+            }
+            frameCapture.capture(framebufferWidth, framebufferHeight);
+            captureRecording = frameCapture.recording();
+            captureFrames = frameCapture.writtenFrames();
+            captureDroppedFrames = frameCapture.droppedFrames();
+            rg::cpuProfiler().end(captureZone);
+
+            /* GPU vreme frejmova od pre nekoliko frejmova, po njemu se bira sledeca rezolucija */
+            postTimer.collect([](const rg::GpuTimerSample &) {});
+            sceneTimer.collect([&](const rg::GpuTimerSample &sample) {
+                benchmark.addGpuSample(sample.tag, sample.milliseconds);
+                frameGpuMilliseconds = sample.milliseconds + postTimer.lastMilliseconds();
+                dynamicResolution.addSample(programState->resolution, frameGpuMilliseconds);
+            });
+            sceneGpuMilliseconds = sceneTimer.lastMilliseconds();
+            passTimer.collect([&](uint32_t frame, const rg::GpuPassSample *passes, unsigned int count) {
+                hitchDetector.addGpuPasses(frame, passes, count);
+            });
+
+            // ImGui nije deo igre, provera alokacija ga ne meri
+            if(programState->ImguiEnabled && !allocationCheck.running()){
+                rg::DebugGroup imguiGroup("ImGui");
+                rg::ProfileZone imguiZone("ImGui");
+                drawImGui();
+                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+            }
+            else
+                glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+            // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+            // -------------------------------------------------------------------------------
+            int swapZone = rg::cpuProfiler().begin("swap and events");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            rg::cpuProfiler().end(swapZone);
+            if (!rg::startupTimeline().finished()) {
+                // prvi frejm je prikazan kad GPU zavrsi i zamenu bafera
+                glFinish();
+                rg::startupTimeline().end(firstFramePhase);
+                rg::startupTimeline().finish();
+                rg::startupTimeline().report(std::cout);
+                if (firstFrameOnly) {
+                    rg::startupTimeline().write(std::cout);
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
 
-        finalShader.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-        finalShader.setInt("bloom", programState->bloom);
-        finalShader.setFloat("exposure", programState->exposure);
-        renderQuad();
-
-        if(programState->ImguiEnabled){
-            drawImGui();
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+            /* Frejm mnogo sporiji od uobicajenog: zone, brojaci i stanje igre idu u log */
+            double frameMilliseconds = (glfwGetTime() - frameStart) * 1000.0;
+            if (hitchDetector.addFrame(programState->hitches, frameMilliseconds)) {
+                hitchDetector.report(frameNumber, frameMilliseconds, rg::cpuProfiler().zones(),
+                                     rg::frameStats().snapshot(rg::glState().currentFrame()),
+                                     {{"obstacles", (double) cubes.size()}, {"score", (double) programState->score},
+                                      {"speed", (double) programState->cubesSpeed}});
+            }
+            hitchDetector.update(frameNumber);
+            hitchCount = hitchDetector.hitchCount();
+            hitchMedianMilliseconds = hitchDetector.medianMilliseconds();
+
+            frameNumber++;
+            previousViewProjection = motionViewProjection;
+            previousSkyViewProjection = skyViewProjection;
+            if (allocationCheck.running()) {
+                allocationCheck.endFrame(rg::cpuProfiler().zones());
+                if (allocationCheck.finished()) {
+                    allocationCheck.report(std::cout);
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
+            if (benchmark.running()) {
+                rg::FrameStats counters = rg::frameStats().snapshot(rg::glState().currentFrame());
+                counters.arenaBytes = rg::frameArena().usedBytes();
+                benchmark.endFrame((glfwGetTime() - frameStart) * 1000.0, counters);
+                if (benchmark.finished()) {
+                    benchmark.report(std::cout);
+                    glfwSetWindowShouldClose(window, true);
+                }
+            }
         }
-        else
-            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // snimak se zavrsava dok kontekst jos postoji
+        frameCapture.stop();
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
@@ -861,7 +1722,7 @@ int main() {
     programState->SaveToFile("resources/program_state.txt");
     cubes.clear();
     glfwTerminate();
-    return 0;
+    return allocationCheck.finished() && !allocationCheck.passed() ? 1 : 0;
 }
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods){
@@ -885,6 +1746,10 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
         programState->ImguiEnabled = !programState->ImguiEnabled;
     }
 
+    if (key == GLFW_KEY_F9 && action == GLFW_PRESS) {
+        captureToggleRequested = true;
+    }
+
 
 
 }
@@ -929,9 +1794,8 @@ void resetGame(){
 
 
 
-void setUpShaderLights(Shader shader){
-
-    shader.setInt("numOfPointLights",programState->numOfPointLights);
+void setUpShaderLights(const Shader &shader, const rg::LightClusters &lightClusters,
+                       const rg::ShadowCascades &shadowCascades){
 
     shader.setVec3("dirLight.direction", programState->dirLight.direction);
     shader.setVec3("dirLight.ambient", programState->dirLight.ambient);
@@ -949,18 +1813,8 @@ void setUpShaderLights(Shader shader){
     shader.setFloat("spotLight.cutOff", programState->spotLight.cutOff);
     shader.setFloat("spotLight.outerCutOff", programState->spotLight.outerCutOff);
 
-    for (int i = 0; i < programState->numOfPointLights; i++) {
-        shader.setVec3("pointLights[" + std::to_string(i) + "]" + ".position", programState->pointLights[i].position);
-        shader.setVec3("pointLights[" + std::to_string(i) + "]" + ".ambient", programState->pointLights[i].ambient);
-        shader.setVec3("pointLights[" + std::to_string(i) + "]" + ".diffuse", programState->pointLights[i].diffuse);
-        shader.setVec3("pointLights[" + std::to_string(i) + "]" + ".specular",programState-> pointLights[i].specular);
-        shader.setFloat("pointLights[" + std::to_string(i) + "]" + ".constant", programState->pointLights[i].constant);
-        shader.setFloat("pointLights[" + std::to_string(i) + "]" + ".linear",programState-> pointLights[i].linear);
-        shader.setFloat("pointLights[" + std::to_string(i) + "]" + ".quadratic",programState-> pointLights[i].quadratic);
-
-
-
-    }
+    lightClusters.setUniforms(shader);
+    shadowCascades.setUniforms(shader);
 
     shader.setVec3("viewPos", camera.Position);
 }
@@ -968,6 +1822,7 @@ void setUpShaderLights(Shader shader){
 /* funkcija za ucitavanje teksture */
 unsigned int loadTexture(char const* path, bool gammaCorrection)
 {
+    rg::ScopedStartupPhase phase(std::string("texture ") + path);
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
@@ -1015,6 +1870,7 @@ unsigned int loadTexture(char const* path, bool gammaCorrection)
 
 /* ucitavanje skyboxa */
 unsigned int loadCubemap(std::vector<std::string> faces) {
+    rg::ScopedStartupPhase phase("cubemap " + (faces.empty() ? std::string() : faces[0]));
     unsigned int textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
@@ -1064,17 +1920,16 @@ void renderQuad()
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        rg::glState().bindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        rg::bufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    rg::glState().bindVertexArray(quadVAO);
+    rg::drawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
 void drawImGui() {
@@ -1084,11 +1939,96 @@ void drawImGui() {
 
     {
         ImGui::Begin("Settings ");
-        ImGui::DragFloat("Exposure", (float *) &programState->exposure, 0.1, 0.1, 10);
+        ImGui::Checkbox("Auto exposure", &programState->autoExposure.enabled);
+        if (programState->autoExposure.enabled) {
+            ImGui::SliderFloat("Exposure compensation (EV)", &programState->autoExposure.compensation, -4.0, 4.0);
+            ImGui::DragFloat("Adaptation speed", &programState->autoExposure.adaptationSpeed, 0.05, 0.1, 10.0);
+            ImGui::Text("Average luminance: %.3f, exposure: %.2f", sceneAverageLuminance, frameExposure);
+        } else {
+            ImGui::DragFloat("Exposure", (float *) &programState->exposure, 0.1, 0.1, 10);
+        }
         ImGui::Checkbox("Enable Bloom", (bool *) &programState->bloom);
         ImGui::DragFloat("Game level", (float* ) &programState->cubesSpeed,0.1,1.5f,7.0);
         ImGui::Text("Score: %d", programState->score);
         ImGui::Text("Highest score: %d", programState->highScore);
+        ImGui::Text("GL state calls: %u issued, %u skipped",
+                    rg::glState().lastFrame().issued, rg::glState().lastFrame().skipped);
+        ImGui::Text("Culled objects: %u", culledObjects);
+        ImGui::Checkbox("Pickup lights", &programState->pickupLights);
+        ImGui::Checkbox("Deferred shading", &programState->deferred);
+        ImGui::Text("Scene GPU time: %.2f ms, frame GPU time: %.2f ms", sceneGpuMilliseconds, frameGpuMilliseconds);
+        ImGui::Checkbox("Temporal AA", &programState->taa);
+        ImGui::Combo("FXAA", &programState->fxaa, [](void *, int index, const char **name) {
+            *name = rg::FXAA_PRESETS[index].name;
+            return true;
+        }, nullptr, rg::FXAA_QUALITY_COUNT);
+        ImGui::Checkbox("Dynamic resolution", &programState->resolution.enabled);
+        ImGui::DragFloat("GPU budget (ms)", &programState->resolution.targetMilliseconds, 0.1, 2.0, 50.0);
+        ImGui::SliderFloat("Min render scale", &programState->resolution.minScale, 0.25, 1.0);
+        ImGui::SliderFloat("Upscale sharpness", &programState->resolution.sharpness, 0.0, 1.0);
+        ImGui::Text("Render scale: %.2f (%dx%d)", sceneRenderScale, sceneRenderSize.x, sceneRenderSize.y);
+        ImGui::Text("Clustered lights: %u lights, %u list entries", clusteredLightCount, clusteredLightEntries);
+        ImGui::Text("Render graph: %u passes, %u culled, transient %zu KiB (%zu KiB without aliasing)",
+                    renderGraphPasses, renderGraphCulledPasses, renderGraphTransientBytes / 1024,
+                    renderGraphUnaliasedBytes / 1024);
+        if (ImGui::Button("Dump render graph"))
+            dumpRenderGraph = true;
+        ImGui::Checkbox("Compact HDR (R11G11B10F)", &programState->compactHdr);
+        int bloomResolution = programState->bloomDownsample >= 4 ? 2 : (programState->bloomDownsample >= 2 ? 1 : 0);
+        if (ImGui::Combo("Bloom resolution", &bloomResolution, "Full\0" "Half\0" "Quarter\0"))
+            programState->bloomDownsample = 1 << bloomResolution;
+        if (ImGui::Button(captureRecording ? "Stop recording (F9)" : "Start recording (F9)"))
+            captureToggleRequested = true;
+        if (captureRecording)
+            ImGui::Text("Recording: %u frames written, %u dropped", captureFrames, captureDroppedFrames);
+        ImGui::Text("HDR targets: %.1f MiB (%.1f MiB before), est. traffic %.1f MB/frame (%.1f MB before)",
+                    hdrTargetBytes / 1048576.0, hdrTargetBaselineBytes / 1048576.0,
+                    hdrTrafficBytes / 1.0e6, hdrTrafficBaselineBytes / 1.0e6);
+        ImGui::End();
+    }
+    {
+        ImGui::Begin("Frame statistics");
+        const rg::FrameStats &last = rg::frameStats().lastFrame();
+        ImGui::Text("Draw calls: %u, vertices: %llu, triangles: %llu", last.drawCalls,
+                    (unsigned long long) last.vertices, (unsigned long long) last.triangles);
+        ImGui::Text("Binds: %u programs, %u VAOs, %u textures", last.programBinds, last.vertexArrayBinds,
+                    last.textureBinds);
+        ImGui::Text("Uniform uploads: %u, buffer uploads: %.1f KiB", last.uniformUploads,
+                    last.bufferUploadBytes / 1024.0);
+        ImGui::Text("Culled objects: %u", last.culledObjects);
+        ImGui::Text("Frame arena: %.1f KiB, high water %.1f of %.1f KiB, %u overflows", last.arenaBytes / 1024.0,
+                    rg::frameArena().highWaterBytes() / 1024.0, rg::frameArena().capacity() / 1024.0,
+                    rg::frameArena().overflows());
+        ImGui::Text("Time to first frame: %.1f ms", rg::startupTimeline().totalMilliseconds());
+        ImGui::Checkbox("Hitch log", &programState->hitches.enabled);
+        if (programState->hitches.enabled) {
+            ImGui::SliderFloat("Hitch factor (x median)", &programState->hitches.medianFactor, 1.2f, 5.0f);
+            ImGui::SliderFloat("Hitch minimum (ms)", &programState->hitches.minMilliseconds, 1.0f, 50.0f);
+            ImGui::Text("Hitches: %u, median frame %.2f ms", hitchCount, hitchMedianMilliseconds);
+        }
+        // istorija poslednjih frejmova, najstariji levo
+        typedef float (*StatsValue)(const rg::FrameStats &);
+        static const StatsValue drawCalls = [](const rg::FrameStats &stats) { return (float) stats.drawCalls; };
+        static const StatsValue triangles = [](const rg::FrameStats &stats) { return (float) stats.triangles; };
+        static const StatsValue binds = [](const rg::FrameStats &stats) {
+            return (float) (stats.programBinds + stats.vertexArrayBinds + stats.textureBinds);
+        };
+        static const StatsValue uniforms = [](const rg::FrameStats &stats) { return (float) stats.uniformUploads; };
+        static const StatsValue uploads = [](const rg::FrameStats &stats) {
+            return (float) (stats.bufferUploadBytes / 1024.0);
+        };
+        static const StatsValue arena = [](const rg::FrameStats &stats) { return (float) (stats.arenaBytes / 1024.0); };
+        auto plot = [](const char *label, const StatsValue &value) {
+            ImGui::PlotLines(label, [](void *data, int index) {
+                return (*(const StatsValue *) data)(rg::frameStats().history((size_t) index));
+            }, (void *) &value, (int) rg::frameStats().historySize(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 40));
+        };
+        plot("Draw calls", drawCalls);
+        plot("Triangles", triangles);
+        plot("Binds", binds);
+        plot("Uniforms", uniforms);
+        plot("Uploads (KiB)", uploads);
+        plot("Frame arena (KiB)", arena);
         ImGui::End();
     }
     {
@@ -1097,6 +2037,14 @@ void drawImGui() {
         ImGui::DragFloat3("ambient", (float *) &(programState->dirLight.ambient), 0.02, 0.0);
         ImGui::DragFloat3("diffuse", (float *) &(programState->dirLight.diffuse), 0.02, 0.0);
         ImGui::DragFloat3("specular", (float *) &(programState->dirLight.specular), 0.02, 0.0);
+        ImGui::Checkbox("Shadows", &programState->shadows.enabled);
+        ImGui::SliderInt("Cascades", &programState->shadows.cascades, 1, rg::MAX_SHADOW_CASCADES);
+        int shadowSize = programState->shadows.resolution >= 2048 ? 2 : (programState->shadows.resolution >= 1024 ? 1 : 0);
+        if (ImGui::Combo("Shadow map size", &shadowSize, "512\0" "1024\0" "2048\0"))
+            programState->shadows.resolution = 512 << shadowSize;
+        ImGui::SliderInt("PCF radius", &programState->shadows.pcfRadius, 0, 3);
+        ImGui::DragFloat("Shadow distance", &programState->shadows.distance, 0.5, 5.0, FAR_PLANE);
+        ImGui::Text("Shadow draws: %u, static cascades redrawn: %u", shadowDraws, shadowStaticRefreshes);
         ImGui::End();
     }
     {